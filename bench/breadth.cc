@@ -0,0 +1,81 @@
+// Times hill climbing at a large kmax with per-depth breadth limits (HillClimber::set_breadth()),
+// against exhaustive search, to show what the limits trade in tour length for time.
+// Each run starts from the same kmax 3 local optimum.
+//
+// Usage: bench/breadth.out [kmax] [point_count]
+
+#include "instances.hh"
+
+#include <NanoTimer.h>
+#include <hill_climber.hh>
+#include <metric.hh>
+#include <point_quadtree/Domain.h>
+#include <point_set.hh>
+#include <spatial_index.hh>
+#include <tour.hh>
+
+#include <cstdlib> // stoul
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+template <typename Metric>
+size_t climb(HillClimber<Metric> &hill_climber, Tour &tour, size_t kmax) {
+    size_t iterations{0};
+    auto kmove = hill_climber.find_best(tour, kmax);
+    while (kmove) {
+        tour.swap(*kmove);
+        hill_climber.changed(*kmove);
+        kmove = hill_climber.find_best(tour, kmax);
+        ++iterations;
+    }
+    return iterations;
+}
+
+std::string to_string(const std::vector<size_t> &breadth) {
+    if (breadth.empty()) {
+        return "exhaustive";
+    }
+    std::string s;
+    for (auto b : breadth) {
+        s += (s.empty() ? "" : ",") + std::to_string(b);
+    }
+    return s;
+}
+
+}  // namespace
+
+int main(int argc, const char **argv) {
+    const size_t kmax = (argc > 1) ? std::stoul(argv[1]) : 6;
+    const size_t n = (argc > 2) ? std::stoul(argv[2]) : 1000;
+    std::cout << std::setprecision(4);
+
+    const auto c = bench::instances::make("uniform", n);
+    const auto &[x, y] = c;
+    const point_quadtree::Domain domain(x, y);
+    const auto index = make_spatial_index("quadtree", x, y, domain);
+    const metric::Euc2d metric(x, y);
+    PointSet point_set(*index, metric);
+    Tour start(&domain, bench::instances::strip_tour(c), metric);
+    HillClimber kmax3_climber(point_set);
+    climb(kmax3_climber, start, 3);
+    std::cout << "uniform (" << x.size() << " points), kmax " << kmax
+        << " from kmax 3 length " << start.length() << std::endl;
+
+    const std::vector<std::vector<size_t>> breadths{{}, {20, 10, 5}, {10, 5, 3}, {5, 3, 2}};
+    for (const auto &breadth : breadths) {
+        Tour tour = start;
+        HillClimber hill_climber(point_set);
+        hill_climber.set_breadth(breadth);
+        NanoTimer timer;
+        timer.start();
+        const auto iterations = climb(hill_climber, tour, kmax);
+        const auto climb_s = timer.stop() / 1e9;
+        std::cout << std::setw(12) << to_string(breadth) << ": climb " << climb_s << " s, "
+            << iterations << " iterations, length " << tour.length() << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,83 @@
+// Times cycle_check::feasible (the closing check of every candidate move in the hill climber)
+// on random k-moves, against counting cycles with cycle_check::count_cycles.
+//
+// Usage: bench/cycle_check.out [max_k] [moves_per_k]
+
+#include "instances.hh"
+
+#include <NanoTimer.h>
+#include <cycle_check.hh>
+#include <kmove.hh>
+#include <metric.hh>
+#include <point_quadtree/Domain.h>
+#include <tour.hh>
+
+#include <algorithm> // shuffle, sort
+#include <cstdlib> // stoul
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+// k deleted edges (none adjacent) reconnected by a random perfect matching of their points.
+std::vector<KMove> random_moves(const Tour &tour, size_t k, size_t count, std::mt19937 &generator) {
+    std::vector<KMove> moves;
+    std::uniform_int_distribution<primitives::sequence_t> position(0, tour.size() / (2 * k) - 1);
+    while (moves.size() < count) {
+        // one edge in the first half of each of k equal stretches of the tour, so no two edges share a point.
+        KMove kmove;
+        std::vector<primitives::point_id_t> points;
+        for (size_t e{0}; e < k; ++e) {
+            const auto p = tour.order()[e * (tour.size() / k) + position(generator)];
+            kmove.removes.push_back(p);
+            points.push_back(p);
+            points.push_back(tour.next(p));
+        }
+        std::shuffle(std::begin(points), std::end(points), generator);
+        for (size_t e{0}; e < k; ++e) {
+            kmove.starts.push_back(points[2 * e]);
+            kmove.ends.push_back(points[2 * e + 1]);
+        }
+        moves.push_back(kmove);
+    }
+    return moves;
+}
+
+}  // namespace
+
+int main(int argc, const char **argv) {
+    const size_t max_k = (argc > 1) ? std::stoul(argv[1]) : 16;
+    const size_t count = (argc > 2) ? std::stoul(argv[2]) : 20000;
+    std::cout << std::setprecision(4);
+    const auto c = bench::instances::make("uniform", 10000);
+    const point_quadtree::Domain domain(c[0], c[1]);
+    const Tour tour(&domain, bench::instances::strip_tour(c), metric::Euc2d(c[0], c[1]));
+    std::mt19937 generator(1);
+    for (size_t k{2}; k <= max_k; k += (k < 4) ? 1 : 2) {
+        const auto moves = random_moves(tour, k, count, generator);
+        NanoTimer timer;
+        size_t feasible{0};
+        timer.start();
+        for (const auto &kmove : moves) {
+            feasible += cycle_check::feasible(tour, kmove);
+        }
+        const auto feasible_ns = static_cast<double>(timer.stop()) / moves.size();
+        size_t single_cycle{0};
+        timer.start();
+        for (const auto &kmove : moves) {
+            single_cycle += cycle_check::count_cycles(tour, kmove) == 1;
+        }
+        const auto count_ns = static_cast<double>(timer.stop()) / moves.size();
+        size_t disagreements{0};
+        for (const auto &kmove : moves) {
+            disagreements += cycle_check::feasible(tour, kmove) != (cycle_check::count_cycles(tour, kmove) == 1);
+        }
+        std::cout << "k " << k << ": feasible " << feasible_ns << " ns"
+            << ", count_cycles " << count_ns << " ns"
+            << " (feasible: " << feasible << ", single cycle: " << single_cycle << " of " << moves.size()
+            << ", " << disagreements << " disagreements)" << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,135 @@
+// Compares computed lengths against the precomputed distance matrix, for a metric that is
+// cheap to compute (EUC_2D) and one that is expensive to compute (GEO): matrix build time,
+// length throughput over nearest-neighbor pairs (the pairs hill climbing asks for),
+// and hill climbing (find_best) time from a strip tour.
+//
+// Usage: bench/distance_matrix.out [kmax] [point_count...]
+// Default sizes are those of xqf131, pbn423 and a few larger instances.
+
+#include "instances.hh"
+
+#include <NanoTimer.h>
+#include <hill_climber.hh>
+#include <metric.hh>
+#include <point_quadtree/Domain.h>
+#include <point_set.hh>
+#include <spatial_index.hh>
+#include <tour.hh>
+
+#include <algorithm> // max, max_element
+#include <cmath> // floor
+#include <cstdlib> // stoul
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t NEIGHBORS{10};
+constexpr size_t LENGTH_REPEATS{20};
+
+template <typename Metric>
+void run(const std::string &name
+    , const Metric &metric
+    , const bench::instances::Coordinates &c
+    , const point_quadtree::Domain &domain
+    , const SpatialIndex &index
+    , const std::vector<std::vector<primitives::point_id_t>> &neighbors
+    , size_t kmax) {
+    PointSet point_set(index, metric);
+    NanoTimer timer;
+    primitives::length_t checksum{0};
+    timer.start();
+    for (size_t r{0}; r < LENGTH_REPEATS; ++r) {
+        for (primitives::point_id_t i{0}; i < point_set.size(); ++i) {
+            for (const auto j : neighbors[i]) {
+                checksum += point_set.length(i, j);
+            }
+        }
+    }
+    const auto lengths = LENGTH_REPEATS * point_set.size() * NEIGHBORS;
+    const auto scalar_ns = static_cast<double>(timer.stop()) / lengths;
+    std::vector<primitives::length_t> out(NEIGHBORS);
+    timer.start();
+    for (size_t r{0}; r < LENGTH_REPEATS; ++r) {
+        for (primitives::point_id_t i{0}; i < point_set.size(); ++i) {
+            point_set.length(i, neighbors[i].data(), neighbors[i].size(), out.data());
+            checksum += out[r % NEIGHBORS];
+        }
+    }
+    const auto batch_ns = static_cast<double>(timer.stop()) / lengths;
+
+    // small instances climb too quickly to time once.
+    const size_t climbs = std::max<size_t>(1, 20000 / point_set.size());
+    primitives::length_t final_length{0};
+    timer.start();
+    for (size_t climb{0}; climb < climbs; ++climb) {
+        Tour tour(&domain, bench::instances::strip_tour(c), metric);
+        HillClimber hill_climber(point_set);
+        auto kmove = hill_climber.find_best(tour, kmax);
+        while (kmove) {
+            tour.swap(*kmove);
+            hill_climber.changed(*kmove);
+            kmove = hill_climber.find_best(tour, kmax);
+        }
+        final_length = tour.length();
+    }
+    const auto climb_ms = timer.stop() / 1e6 / climbs;
+
+    std::cout << name << ": length " << scalar_ns << " ns"
+        << ", batch length " << batch_ns << " ns"
+        << ", climb (kmax " << kmax << ") " << climb_ms << " ms"
+        << " (final length " << final_length << ")"
+        << " [checksum " << checksum << "]" << std::endl;
+}
+
+template <typename Base>
+void compare(const std::string &name, const Base &base, const bench::instances::Coordinates &c, size_t kmax) {
+    const auto &[x, y] = c;
+    const point_quadtree::Domain domain(x, y);
+    const auto index = make_spatial_index("grid", x, y, domain);
+    const auto neighbors = index->knn(NEIGHBORS);
+    run(name + " computed", base, c, domain, *index, neighbors, kmax);
+    NanoTimer timer;
+    timer.start();
+    const metric::Matrix<Base> matrix(base, x.size());
+    const auto build_ms = timer.stop() / 1e6;
+    std::cout << name << " matrix: " << matrix.bytes(x.size()) / 1e6 << " MB"
+        << ", built in " << build_ms << " ms" << std::endl;
+    run(name + " matrix", matrix, c, domain, *index, neighbors, kmax);
+}
+
+}  // namespace
+
+int main(int argc, const char **argv) {
+    const size_t kmax = (argc > 1) ? std::stoul(argv[1]) : 3;
+    std::vector<size_t> sizes;
+    for (int a{2}; a < argc; ++a) {
+        sizes.push_back(std::stoul(argv[a]));
+    }
+    if (sizes.empty()) {
+        sizes = {131, 423, 1000, 5000};
+    }
+    std::cout << std::setprecision(4);
+    for (const auto n : sizes) {
+        const auto c = bench::instances::make("uniform", n);
+        std::cout << "\nuniform (" << c[0].size() << " points)" << std::endl;
+        compare("EUC_2D", metric::Euc2d(c[0], c[1]), c, kmax);
+
+        // the same points as DDD.MM coordinates in a 10 x 10 degree region.
+        const auto side = *std::max_element(std::cbegin(c[0]), std::cend(c[0])) + 1;
+        const auto to_geo = [side](primitives::space_t v) {
+            const auto degrees = 40 + 10 * v / side;
+            const auto whole = std::floor(degrees);
+            return whole + std::floor(60 * (degrees - whole)) / 100;
+        };
+        bench::instances::Coordinates geo;
+        for (primitives::point_id_t i{0}; i < c[0].size(); ++i) {
+            geo[0].push_back(to_geo(c[0][i]));
+            geo[1].push_back(to_geo(c[1][i]));
+        }
+        compare("GEO", metric::Geo(geo[0], geo[1]), geo, kmax);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,68 @@
+// Times hill climbing (find_best) at a high kmax, where the search spends most of its time
+// on the bookkeeping of deep partial moves rather than on neighborhood queries.
+// The tour is first climbed at kmax 3 (untimed), as k-opt does before larger moves are worth searching.
+// Search time grows steeply with kmax, so the default instance is small.
+//
+// Usage: bench/hill_climber.out [kmax] [point_count]
+
+#include "instances.hh"
+
+#include <NanoTimer.h>
+#include <hill_climber.hh>
+#include <metric.hh>
+#include <point_quadtree/Domain.h>
+#include <point_set.hh>
+#include <spatial_index.hh>
+#include <tour.hh>
+
+#include <cstdlib> // stoul
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace {
+
+template <typename Metric>
+size_t climb(HillClimber<Metric> &hill_climber, Tour &tour, size_t kmax) {
+    size_t iterations{0};
+    auto kmove = hill_climber.find_best(tour, kmax);
+    while (kmove) {
+        tour.swap(*kmove);
+        hill_climber.changed(*kmove);
+        kmove = hill_climber.find_best(tour, kmax);
+        ++iterations;
+    }
+    return iterations;
+}
+
+void run(const std::string &name, const bench::instances::Coordinates &c, size_t kmax) {
+    const auto &[x, y] = c;
+    const point_quadtree::Domain domain(x, y);
+    const auto index = make_spatial_index("quadtree", x, y, domain);
+    const metric::Euc2d metric(x, y);
+    PointSet point_set(*index, metric);
+    Tour tour(&domain, bench::instances::strip_tour(c), metric);
+    HillClimber kmax3_climber(point_set);
+    climb(kmax3_climber, tour, 3);
+    const auto start_length = tour.length();
+
+    // a new climber, as the kmax 3 climber has already searched every point.
+    HillClimber hill_climber(point_set);
+    NanoTimer timer;
+    timer.start();
+    const auto iterations = climb(hill_climber, tour, kmax);
+    const auto climb_s = timer.stop() / 1e9;
+    std::cout << name << " (" << x.size() << " points): kmax " << kmax
+        << " climb " << climb_s << " s, " << iterations << " iterations"
+        << " (length " << start_length << " -> " << tour.length() << ")" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, const char **argv) {
+    const size_t kmax = (argc > 1) ? std::stoul(argv[1]) : 10;
+    const size_t n = (argc > 2) ? std::stoul(argv[2]) : 100;
+    std::cout << std::setprecision(4);
+    run("uniform", bench::instances::make("uniform", n), kmax);
+    return EXIT_SUCCESS;
+}
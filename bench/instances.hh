@@ -0,0 +1,132 @@
+#pragma once
+
+// Synthetic instances for benchmarks, so that benchmarks run without downloaded data.
+
+#include <primitives.hh>
+
+#include <algorithm> // sort
+#include <array>
+#include <cmath> // floor
+#include <numeric> // iota
+#include <random>
+#include <set>
+#include <string>
+#include <utility> // pair
+#include <vector>
+
+namespace bench {
+namespace instances {
+
+using Coordinates = std::array<std::vector<primitives::space_t>, 2>;
+
+// integer coordinates uniformly distributed in a square.
+inline Coordinates uniform(size_t n, unsigned seed = 1) {
+    std::mt19937 generator(seed);
+    const primitives::space_t side = std::ceil(std::sqrt(n) * 10);
+    std::uniform_real_distribution<primitives::space_t> coordinate(0, side);
+    Coordinates c;
+    for (size_t i{0}; i < n; ++i) {
+        c[0].push_back(std::floor(coordinate(generator)));
+        c[1].push_back(std::floor(coordinate(generator)));
+    }
+    return c;
+}
+
+// dense gaussian clusters with empty space in between.
+inline Coordinates clustered(size_t n, unsigned seed = 1) {
+    std::mt19937 generator(seed);
+    const primitives::space_t side = std::ceil(std::sqrt(n) * 10);
+    const size_t cluster_count = std::max<size_t>(1, n / 1000);
+    std::uniform_real_distribution<primitives::space_t> center(0, side);
+    std::vector<std::array<primitives::space_t, 2>> centers(cluster_count);
+    for (auto &c : centers) {
+        c = {center(generator), center(generator)};
+    }
+    std::normal_distribution<primitives::space_t> offset(0, side / 100);
+    std::uniform_int_distribution<size_t> pick(0, cluster_count - 1);
+    Coordinates c;
+    for (size_t i{0}; i < n; ++i) {
+        const auto &cluster = centers[pick(generator)];
+        c[0].push_back(std::floor(cluster[0] + offset(generator)));
+        c[1].push_back(std::floor(cluster[1] + offset(generator)));
+    }
+    return c;
+}
+
+// "national" style: points concentrated around cities of widely varying size,
+// plus a sparse rural background, like the national TSPs.
+inline Coordinates national(size_t n, unsigned seed = 1) {
+    std::mt19937 generator(seed);
+    const primitives::space_t side = std::ceil(std::sqrt(n) * 10);
+    std::uniform_real_distribution<primitives::space_t> uniform(0, side);
+    std::uniform_real_distribution<primitives::space_t> unit(0, 1);
+    const size_t city_count = std::max<size_t>(1, n / 200);
+    std::vector<std::array<primitives::space_t, 3>> cities(city_count); // x, y, spread.
+    for (auto &city : cities) {
+        const auto size = std::pow(unit(generator), 3); // few large cities, many small ones.
+        city = {uniform(generator), uniform(generator), side * (0.002 + 0.03 * size)};
+    }
+    std::uniform_int_distribution<size_t> pick(0, city_count - 1);
+    Coordinates c;
+    for (size_t i{0}; i < n; ++i) {
+        if (unit(generator) < 0.2) {
+            c[0].push_back(std::floor(uniform(generator)));
+            c[1].push_back(std::floor(uniform(generator)));
+            continue;
+        }
+        const auto &city = cities[pick(generator)];
+        std::normal_distribution<primitives::space_t> offset(0, city[2]);
+        c[0].push_back(std::floor(city[0] + offset(generator)));
+        c[1].push_back(std::floor(city[1] + offset(generator)));
+    }
+    return c;
+}
+
+// removes repeated points, keeping the first occurrence.
+inline Coordinates distinct(const Coordinates &c) {
+    std::set<std::pair<primitives::space_t, primitives::space_t>> seen;
+    Coordinates d;
+    for (size_t i{0}; i < c[0].size(); ++i) {
+        if (seen.emplace(c[0][i], c[1][i]).second) {
+            d[0].push_back(c[0][i]);
+            d[1].push_back(c[1][i]);
+        }
+    }
+    return d;
+}
+
+// type: uniform, clustered, or national. Points are distinct.
+inline Coordinates make(const std::string &type, size_t n, unsigned seed = 1) {
+    if (type == "clustered") {
+        return distinct(clustered(n, seed));
+    }
+    if (type == "national") {
+        return distinct(national(n, seed));
+    }
+    return distinct(uniform(n, seed));
+}
+
+// boustrophedon strip tour; a cheap, reasonable starting tour.
+inline std::vector<primitives::point_id_t> strip_tour(const Coordinates &c) {
+    const auto &x = c[0];
+    const auto &y = c[1];
+    const auto n = x.size();
+    const auto [ymin, ymax] = std::minmax_element(std::cbegin(y), std::cend(y));
+    const primitives::space_t strips = std::max(1.0, std::floor(std::sqrt(n / 2.0)));
+    const primitives::space_t strip_height = (*ymax - *ymin) / strips + 1;
+    const auto strip = [&](primitives::point_id_t i) { return static_cast<size_t>((y[i] - *ymin) / strip_height); };
+    std::vector<primitives::point_id_t> order(n);
+    std::iota(std::begin(order), std::end(order), 0);
+    std::sort(std::begin(order), std::end(order), [&](auto a, auto b) {
+        const auto sa = strip(a);
+        const auto sb = strip(b);
+        if (sa != sb) {
+            return sa < sb;
+        }
+        return (sa & 1) ? x[a] > x[b] : x[a] < x[b];
+    });
+    return order;
+}
+
+}  // namespace instances
+}  // namespace bench
@@ -0,0 +1,99 @@
+// Times merge::merge on tours that differ by many small, independent segment reversals,
+// so that the diff is large (2 edges per reversal) and most of the time goes to decomposing it
+// (edge_differences, disjoin, improvements, cycle checks) rather than to the combination search.
+// The reversed tour is the current tour, so most exchanges improve it and are applied.
+// Then times a multi-parent merge of the reversed tour with a pool of tours reversed with other seeds.
+//
+// Usage: bench/merge.out [point_count] [repeats]
+
+#include "instances.hh"
+
+#include <NanoTimer.h>
+#include <merge/merge.hh>
+#include <metric.hh>
+#include <point_quadtree/Domain.h>
+#include <spatial_index.hh>
+#include <tour.hh>
+
+#include <algorithm> // reverse
+#include <cstdlib> // stoul
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+// reverses a segment of 2 to 5 points in every stretch of 8, leaving the points between segments in place.
+std::vector<primitives::point_id_t> reverse_segments(std::vector<primitives::point_id_t> order, unsigned seed) {
+    constexpr size_t STRETCH{8};
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<size_t> size(2, 5);
+    for (size_t start{1}; start + STRETCH < order.size(); start += STRETCH) {
+        const auto begin = std::begin(order) + static_cast<std::ptrdiff_t>(start);
+        std::reverse(begin, begin + static_cast<std::ptrdiff_t>(size(generator)));
+    }
+    return order;
+}
+
+}  // namespace
+
+int main(int argc, const char **argv) {
+    const size_t n = (argc > 1) ? std::stoul(argv[1]) : 400000;
+    const size_t repeats = (argc > 2) ? std::stoul(argv[2]) : 3;
+    constexpr size_t POOL_SIZE{8};
+    std::cout << std::setprecision(4);
+    const auto c = bench::instances::make("uniform", n);
+    const auto &[x, y] = c;
+    const point_quadtree::Domain domain(x, y);
+    const auto index = make_spatial_index("quadtree", x, y, domain);
+    const metric::Euc2d metric(x, y);
+    const auto strip = bench::instances::strip_tour(c);
+    const Tour candidate(&domain, strip, metric);
+    const auto reversed = reverse_segments(strip, 1);
+
+    NanoTimer timer;
+    double diff_s{0};
+    double disjoin_s{0};
+    double merge_s{0};
+    size_t diff_edges{0};
+    size_t exchanges{0};
+    primitives::length_t merged_length{0};
+    for (size_t r{0}; r < repeats; ++r) {
+        Tour current(&domain, reversed, metric);
+        timer.start();
+        const auto [old_edges, new_edges] = merge::edge_differences(current, candidate);
+        diff_s += timer.stop() / 1e9;
+        timer.start();
+        exchanges = merge::disjoin(old_edges, new_edges).size();
+        disjoin_s += timer.stop() / 1e9;
+        diff_edges = old_edges.size();
+        timer.start();
+        merge::merge(current, candidate, *index);
+        merge_s += timer.stop() / 1e9;
+        merged_length = current.length();
+    }
+    std::cout << "uniform (" << n << " points): " << diff_edges << " differing edges, " << exchanges << " exchanges" << std::endl;
+    std::cout << "edge_differences " << diff_s / repeats << " s, disjoin " << disjoin_s / repeats
+        << " s, merge " << merge_s / repeats << " s (length " << Tour(&domain, reversed, metric).length()
+        << " -> " << merged_length << ", candidate " << candidate.length() << ")" << std::endl;
+
+    merge::Pool pool(POOL_SIZE);
+    timer.start();
+    for (unsigned seed{2}; not pool.full(); ++seed) {
+        pool.add(Tour(&domain, reverse_segments(strip, seed), metric));
+    }
+    const auto pool_add_s = timer.stop() / 1e9;
+    double pool_merge_s{0};
+    for (size_t r{0}; r < repeats; ++r) {
+        Tour current(&domain, reversed, metric);
+        timer.start();
+        merge::merge(current, pool, *index);
+        pool_merge_s += timer.stop() / 1e9;
+        merged_length = current.length();
+    }
+    std::cout << "pool of " << pool.size() << ": adding " << pool_add_s << " s (with tour construction), "
+        << pool.distinct_edges() << " distinct edges, " << pool.common_edges() << " common; merge "
+        << pool_merge_s / repeats << " s (length " << merged_length << ")" << std::endl;
+    return EXIT_SUCCESS;
+}
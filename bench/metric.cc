@@ -0,0 +1,114 @@
+// Compares the distance metric policies: scalar and batch length throughput,
+// and hill climbing (find_best) time from a strip tour.
+// EUC_2D is the reference; the other metrics should cost no more than their formulas.
+//
+// Usage: bench/metric.out [point_count] [kmax]
+
+#include "instances.hh"
+
+#include <NanoTimer.h>
+#include <hill_climber.hh>
+#include <metric.hh>
+#include <point_quadtree/Domain.h>
+#include <point_set.hh>
+#include <spatial_index.hh>
+#include <tour.hh>
+
+#include <algorithm> // max_element
+#include <cmath> // floor
+#include <cstdlib> // stoul
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+template <typename Metric>
+void run(const std::string &name
+    , const Metric &metric
+    , const std::vector<primitives::space_t> &x
+    , const std::vector<primitives::space_t> &y
+    , size_t kmax) {
+    const point_quadtree::Domain domain(x, y);
+    const auto index = make_spatial_index("quadtree", x, y, domain);
+    PointSet point_set(*index, metric);
+
+    // lengths from every point to a fixed, scattered set of points.
+    constexpr size_t TARGETS{64};
+    std::vector<primitives::point_id_t> targets(TARGETS);
+    std::mt19937 generator(1);
+    std::uniform_int_distribution<primitives::point_id_t> point(0, x.size() - 1);
+    for (auto &t : targets) {
+        t = point(generator);
+    }
+    std::vector<primitives::length_t> out(TARGETS);
+    NanoTimer timer;
+    primitives::length_t checksum{0};
+    timer.start();
+    for (primitives::point_id_t i{0}; i < x.size(); ++i) {
+        for (const auto t : targets) {
+            checksum += point_set.length(i, t);
+        }
+    }
+    const auto scalar_ns = static_cast<double>(timer.stop()) / (x.size() * TARGETS);
+    timer.start();
+    for (primitives::point_id_t i{0}; i < x.size(); ++i) {
+        point_set.length(i, targets.data(), TARGETS, out.data());
+        checksum += out[i % TARGETS];
+    }
+    const auto batch_ns = static_cast<double>(timer.stop()) / (x.size() * TARGETS);
+
+    Tour tour(&domain, bench::instances::strip_tour({x, y}), metric);
+    HillClimber hill_climber(point_set);
+    timer.start();
+    auto kmove = hill_climber.find_best(tour, kmax);
+    while (kmove) {
+        tour.swap(*kmove);
+        hill_climber.changed(*kmove);
+        kmove = hill_climber.find_best(tour, kmax);
+    }
+    const auto climb_s = timer.stop() / 1e9;
+
+    std::cout << name << ": length " << scalar_ns << " ns"
+        << ", batch length " << batch_ns << " ns"
+        << ", climb (kmax " << kmax << ") " << climb_s << " s"
+        << " (final length " << tour.length() << ")"
+        << " [checksum " << checksum << "]" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, const char **argv) {
+    const size_t n = (argc > 1) ? std::stoul(argv[1]) : 5000;
+    const size_t kmax = (argc > 2) ? std::stoul(argv[2]) : 3;
+    std::cout << std::setprecision(4);
+    const auto [x, y] = bench::instances::make("uniform", n);
+    std::cout << "uniform (" << x.size() << " points)\n";
+    run("EUC_2D", metric::Euc2d(x, y), x, y, kmax);
+    run("CEIL_2D", metric::Ceil2d(x, y), x, y, kmax);
+    run("ATT", metric::Att(x, y), x, y, kmax);
+    std::vector<primitives::space_t> z(x.size());
+    std::mt19937 generator(1);
+    std::uniform_int_distribution<int> height(0, 100);
+    for (auto &h : z) {
+        h = height(generator);
+    }
+    run("EUC_3D", metric::Euc3d(x, y, z), x, y, kmax);
+
+    // GEO: the same points mapped to a 10 x 10 degree region, in DDD.MM format.
+    const auto side = *std::max_element(std::cbegin(x), std::cend(x)) + 1;
+    const auto to_geo = [side](primitives::space_t c) {
+        const auto degrees = 40 + 10 * c / side;
+        const auto whole = std::floor(degrees);
+        return whole + std::floor(60 * (degrees - whole)) / 100;
+    };
+    std::vector<primitives::space_t> latitude, longitude;
+    for (primitives::point_id_t i{0}; i < x.size(); ++i) {
+        latitude.push_back(to_geo(x[i]));
+        longitude.push_back(to_geo(y[i]));
+    }
+    run("GEO", metric::Geo(latitude, longitude), latitude, longitude, kmax);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,73 @@
+// Times NonsequentialFinder: combining the infeasible (multi-cycle) moves that a kmax 3 search
+// collects on a 3-opt tour into feasible ones. The tour is climbed first (untimed).
+// Every combination found is checked with cycle_check::count_cycles.
+//
+// Usage: bench/nonsequential.out [point_count]...
+
+#include "instances.hh"
+
+#include <NanoTimer.h>
+#include <config.hh>
+#include <cycle_check.hh>
+#include <hill_climb.hh>
+#include <hill_climb/NonsequentialFinder.h>
+#include <metric.hh>
+#include <point_quadtree/Domain.h>
+#include <point_quadtree/point_quadtree.h>
+#include <point_set.hh>
+#include <spatial_index.hh>
+#include <tour.hh>
+
+#include <cstdlib> // stoul
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+int main(int argc, const char **argv) {
+    std::vector<size_t> sizes;
+    for (int a{1}; a < argc; ++a) {
+        sizes.push_back(std::stoul(argv[a]));
+    }
+    if (sizes.empty()) {
+        sizes = {1000, 5000, 20000};
+    }
+    std::cout << std::setprecision(4);
+    // no file: kmax 3.
+    const Config config("");
+    for (auto n : sizes) {
+        const auto c = bench::instances::make("uniform", n);
+        const auto &[x, y] = c;
+        const point_quadtree::Domain domain(x, y);
+        const auto index = make_spatial_index("quadtree", x, y, domain);
+        const point_quadtree::CoincidentGroups groups(x, y, {});
+        const auto root = point_quadtree::make_quadtree(x, y, domain, groups);
+        const metric::Euc2d metric(x, y);
+        const PointSet point_set(*index, metric);
+        Tour tour(&domain, bench::instances::strip_tour(c), metric);
+        hill_climb::hill_climb(point_set, tour, 3);
+
+        hill_climb::NonsequentialFinder finder(config, root, tour);
+        NanoTimer timer;
+        timer.start();
+        const auto feasible = finder.find_best();
+        const auto collect_s = timer.stop() / 1e9;
+        timer.start();
+        finder.find_best_nonsequential();
+        const auto combine_s = timer.stop() / 1e9;
+
+        size_t wrong{0};
+        for (const auto &kmove : finder.single_cycle_moves()) {
+            wrong += cycle_check::count_cycles(tour, kmove) != 1;
+        }
+        for (const auto &kmove : finder.double_cycle_moves()) {
+            wrong += cycle_check::count_cycles(tour, kmove) != 2;
+        }
+        std::cout << "uniform " << x.size() << ": collect " << collect_s << " s"
+            << (feasible ? " (stopped at a feasible move)" : "")
+            << ", combine " << finder.nonsequential_moves() << " moves " << combine_s << " s"
+            << ", " << finder.single_cycle_moves().size() << " single-cycle"
+            << ", " << finder.double_cycle_moves().size() << " double-cycle"
+            << ", " << wrong << " miscounted" << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,71 @@
+// Compares the quadtree and grid spatial indices:
+// box query latency, kNN latency, and hill climbing (find_best) throughput.
+//
+// Usage: bench/spatial_index.out [point_count] [kmax]
+
+#include "instances.hh"
+
+#include <NanoTimer.h>
+#include <hill_climber.hh>
+#include <metric.hh>
+#include <point_quadtree/Domain.h>
+#include <point_set.hh>
+#include <spatial_index.hh>
+#include <tour.hh>
+
+#include <cmath> // sqrt
+#include <cstdlib> // stoul
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+int main(int argc, const char **argv) {
+    const size_t n = (argc > 1) ? std::stoul(argv[1]) : 20000;
+    const size_t kmax = (argc > 2) ? std::stoul(argv[2]) : 3;
+    std::cout << std::setprecision(4);
+    for (const std::string type : {"uniform", "clustered", "national"}) {
+        const auto [x, y] = bench::instances::make(type, n);
+        const point_quadtree::Domain domain(x, y);
+        const primitives::length_t radius = 2 * std::sqrt(domain.xdim(0) * domain.ydim(0) / x.size());
+        std::cout << "\n" << type << " (" << x.size() << " points, query radius " << radius << ")\n";
+        for (const std::string index_type : {"quadtree", "grid"}) {
+            const auto index = make_spatial_index(index_type, x, y, domain);
+            const metric::Euc2d metric(x, y);
+            PointSet point_set(*index, metric);
+
+            NanoTimer timer;
+            size_t returned{0};
+            timer.start();
+            for (primitives::point_id_t i{0}; i < x.size(); ++i) {
+                returned += point_set.get_points(i, radius).size();
+            }
+            const auto query_ns = static_cast<double>(timer.stop()) / x.size();
+
+            timer.start();
+            for (primitives::point_id_t i{0}; i < x.size(); ++i) {
+                returned += point_set.knn(i, 8).size();
+            }
+            const auto knn_ns = static_cast<double>(timer.stop()) / x.size();
+
+            Tour tour(&domain, bench::instances::strip_tour({x, y}), metric);
+            HillClimber hill_climber(point_set);
+            size_t moves{0};
+            timer.start();
+            auto kmove = hill_climber.find_best(tour, kmax);
+            while (kmove) {
+                tour.swap(*kmove);
+                hill_climber.changed(*kmove);
+                kmove = hill_climber.find_best(tour, kmax);
+                ++moves;
+            }
+            const auto climb_s = timer.stop() / 1e9;
+
+            std::cout << index_type << ": box query " << query_ns << " ns"
+                << ", knn(8) " << knn_ns << " ns"
+                << ", climb (kmax " << kmax << ") " << climb_s << " s"
+                << " (" << moves / climb_s << " improving find_best calls / s, final length " << tour.length() << ")"
+                << " [checksum " << returned << "]" << std::endl;
+        }
+    }
+    return EXIT_SUCCESS;
+}
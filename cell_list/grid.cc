@@ -0,0 +1,140 @@
+#include "grid.hh"
+
+#include <algorithm> // clamp, max, nth_element, sort
+#include <cmath> // floor, sqrt
+#include <utility> // pair
+
+namespace cell_list {
+
+Grid::Grid(const std::vector<primitives::space_t> &x
+    , const std::vector<primitives::space_t> &y
+    , const point_quadtree::Domain &domain
+    , const std::vector<primitives::space_t> &z
+    , size_t coincident_members)
+    : x_(x), y_(y), groups_(x, y, z, coincident_members), xmin_(domain.xmin()), ymin_(domain.ymin()) {
+    const auto xrange = domain.xdim(0);
+    const auto yrange = domain.ydim(0);
+    const auto locations = x.size() - groups_.duplicates();
+    const primitives::space_t n = std::max<size_t>(locations, 1);
+    // about one location per cell, which is close to the average edge length of a good tour.
+    cell_size_ = std::sqrt(xrange * yrange / n);
+    if (not (cell_size_ > 0)) {
+        // degenerate (collinear) domain.
+        cell_size_ = std::max({xrange, yrange, primitives::space_t{1}}) / n;
+    }
+    columns_ = static_cast<primitives::grid_t>(xrange / cell_size_) + 1;
+    rows_ = static_cast<primitives::grid_t>(yrange / cell_size_) + 1;
+
+    // counting sort of representatives by cell.
+    const size_t cells = static_cast<size_t>(columns_) * rows_;
+    cell_start_.assign(cells + 1, 0);
+    std::vector<size_t> point_cells(x.size());
+    for (primitives::point_id_t i{0}; i < x.size(); ++i) {
+        if (groups_.representative_of_itself(i)) {
+            point_cells[i] = cell(column(x[i]), row(y[i]));
+            ++cell_start_[point_cells[i] + 1];
+        }
+    }
+    for (size_t c{0}; c < cells; ++c) {
+        cell_start_[c + 1] += cell_start_[c];
+    }
+    points_.resize(locations);
+    auto fill = cell_start_;
+    for (primitives::point_id_t i{0}; i < x.size(); ++i) {
+        if (groups_.representative_of_itself(i)) {
+            points_[fill[point_cells[i]]++] = i;
+        }
+    }
+}
+
+// clamped before the integer conversion, as query boxes may be unbounded (e.g. GEO near the poles).
+primitives::grid_t Grid::column(primitives::space_t x) const {
+    const auto c = std::floor((x - xmin_) / cell_size_);
+    return static_cast<primitives::grid_t>(std::clamp(c, primitives::space_t{0}, primitives::space_t(columns_ - 1)));
+}
+
+primitives::grid_t Grid::row(primitives::space_t y) const {
+    const auto r = std::floor((y - ymin_) / cell_size_);
+    return static_cast<primitives::grid_t>(std::clamp(r, primitives::space_t{0}, primitives::space_t(rows_ - 1)));
+}
+
+std::vector<primitives::point_id_t> Grid::get_points(primitives::point_id_t i, const Box &box) const {
+    std::vector<primitives::point_id_t> points;
+    const auto c0 = column(box.xmin);
+    const auto c1 = column(box.xmax);
+    const auto r0 = row(box.ymin);
+    const auto r1 = row(box.ymax);
+    for (auto r = r0; r <= r1; ++r) {
+        // cells c0 to c1 of a row are contiguous.
+        const auto begin = std::cbegin(points_) + cell_start_[cell(c0, r)];
+        const auto end = std::cbegin(points_) + cell_start_[cell(c1, r) + 1];
+        points.insert(std::end(points), begin, end);
+    }
+    groups_.expand(i, points);
+    return points;
+}
+
+std::vector<primitives::point_id_t> Grid::knn(primitives::point_id_t i, size_t k) const {
+    // search rings of cells around i's cell, until k locations other than i's are within the covered radius
+    // (i's own may be among the candidates, as i need not be its representative).
+    const auto cx = column(x_[i]);
+    const auto cy = row(y_[i]);
+    const auto max_ring = std::max({cx, columns_ - 1 - cx, cy, rows_ - 1 - cy});
+    using Candidate = std::pair<primitives::space_t, primitives::point_id_t>; // squared distance, point.
+    std::vector<Candidate> candidates;
+    const auto add_span = [this, i, &candidates](primitives::grid_t c0, primitives::grid_t c1, primitives::grid_t r) {
+        c0 = std::max(c0, 0);
+        c1 = std::min(c1, columns_ - 1);
+        if (r < 0 or r >= rows_ or c0 > c1) {
+            return;
+        }
+        for (auto p = cell_start_[cell(c0, r)]; p < cell_start_[cell(c1, r) + 1]; ++p) {
+            const auto j = points_[p];
+            if (j == i) {
+                continue;
+            }
+            const auto dx = x_[i] - x_[j];
+            const auto dy = y_[i] - y_[j];
+            candidates.emplace_back(dx * dx + dy * dy, j);
+        }
+    };
+    for (primitives::grid_t ring{0}; ring <= max_ring; ++ring) {
+        if (ring == 0) {
+            add_span(cx, cx, cy);
+        } else {
+            add_span(cx - ring, cx + ring, cy - ring);
+            add_span(cx - ring, cx + ring, cy + ring);
+            for (auto r = cy - ring + 1; r < cy + ring; ++r) {
+                add_span(cx - ring, cx - ring, r);
+                add_span(cx + ring, cx + ring, r);
+            }
+        }
+        // every point within this distance of i has been seen.
+        const auto covered = ring * cell_size_;
+        const auto covered_count = std::count_if(std::cbegin(candidates), std::cend(candidates)
+            , [covered](const auto &c) { return c.first <= covered * covered; });
+        if (static_cast<size_t>(covered_count) > k) {
+            break;
+        }
+    }
+    const auto count = std::min(k + 1, candidates.size());
+    std::nth_element(std::begin(candidates), std::begin(candidates) + static_cast<std::ptrdiff_t>(count), std::end(candidates));
+    candidates.resize(count);
+    std::sort(std::begin(candidates), std::end(candidates));
+    std::vector<primitives::point_id_t> representatives;
+    representatives.reserve(count);
+    for (const auto &c : candidates) {
+        representatives.push_back(c.second);
+    }
+    return groups_.nearest(i, representatives, k);
+}
+
+size_t Grid::max_cell_points() const {
+    size_t max{0};
+    for (size_t c{0}; c + 1 < cell_start_.size(); ++c) {
+        max = std::max<size_t>(max, cell_start_[c + 1] - cell_start_[c]);
+    }
+    return max;
+}
+
+}  // namespace cell_list
@@ -0,0 +1,61 @@
+#pragma once
+
+// Uniform grid (cell list) spatial index.
+// Cells are sized to roughly the average tour edge of a good tour, and points are
+// stored contiguously by cell in row-major order (compressed sparse row layout),
+// so a box query is a handful of contiguous scans, one per grid row, with no tree descent.
+// Best suited for near-uniform point distributions (e.g. VLSI instances).
+// Like the quadtree, cells hold one representative per location, which queries expand into its coincident group.
+
+#include <box.hh>
+#include <point_quadtree/coincident_groups.hh>
+#include <point_quadtree/Domain.h>
+#include <primitives.hh>
+#include <spatial_index.hh>
+
+#include <vector>
+
+namespace cell_list {
+
+class Grid : public SpatialIndex {
+ public:
+    // z (empty for planar points) only decides which points coincide;
+    // coincident_members as for point_quadtree::CoincidentGroups.
+    Grid(const std::vector<primitives::space_t> &x
+        , const std::vector<primitives::space_t> &y
+        , const point_quadtree::Domain &domain
+        , const std::vector<primitives::space_t> &z = {}
+        , size_t coincident_members = 0);
+
+    std::vector<primitives::point_id_t> get_points(primitives::point_id_t i, const Box &box) const override;
+
+    using SpatialIndex::knn;
+    std::vector<primitives::point_id_t> knn(primitives::point_id_t i, size_t k) const override;
+
+    primitives::point_id_t size() const override { return x_.size(); }
+
+    primitives::grid_t columns() const { return columns_; }
+    primitives::grid_t rows() const { return rows_; }
+    // most locations in a cell.
+    size_t max_cell_points() const;
+    size_t duplicates() const { return groups_.duplicates(); }
+
+ private:
+    const std::vector<primitives::space_t> &x_;
+    const std::vector<primitives::space_t> &y_;
+    const point_quadtree::CoincidentGroups groups_;
+    primitives::space_t xmin_{0};
+    primitives::space_t ymin_{0};
+    primitives::space_t cell_size_{1};
+    primitives::grid_t columns_{1};
+    primitives::grid_t rows_{1};
+    // representatives in cell c are points_[cell_start_[c]] to points_[cell_start_[c + 1] - 1].
+    std::vector<primitives::point_id_t> cell_start_;
+    std::vector<primitives::point_id_t> points_;
+
+    primitives::grid_t column(primitives::space_t x) const;
+    primitives::grid_t row(primitives::space_t y) const;
+    size_t cell(primitives::grid_t column, primitives::grid_t row) const { return static_cast<size_t>(row) * columns_ + column; }
+};
+
+}  // namespace cell_list
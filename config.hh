@@ -15,6 +15,7 @@
 #include <string>
 #include <unordered_map>
 #include <variant>
+#include <vector>
 
 class Config
 {
@@ -29,6 +30,9 @@ public:
 
     bool has(const std::string& key) const;
 
+    // a single number, or comma-separated numbers (e.g. "10,5,3"); empty if the key is missing.
+    std::vector<size_t> get_sizes(const std::string& key) const;
+
 private:
     using Variant = std::variant<std::string, bool, size_t, long, double>;
     std::unordered_map<std::string, Variant> m_dictionary;
@@ -117,3 +121,21 @@ inline bool Config::has(const std::string& key) const {
     return m_dictionary.find(key) != std::cend(m_dictionary);
 }
 
+inline std::vector<size_t> Config::get_sizes(const std::string& key) const {
+    std::vector<size_t> sizes;
+    if (not has(key)) {
+        return sizes;
+    }
+    const auto& value = m_dictionary.at(key);
+    if (std::holds_alternative<size_t>(value)) {
+        sizes.push_back(std::get<size_t>(value));
+        return sizes;
+    }
+    std::stringstream stream(std::get<std::string>(value));
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        sizes.push_back(std::stoul(item));
+    }
+    return sizes;
+}
+
@@ -1,5 +1,8 @@
 #include "cycle_check.hh"
 
+#include <array>
+#include <cstdint> // uint8_t
+
 namespace cycle_check {
 
 namespace {
@@ -63,6 +66,203 @@ bool breaks_cycle_(const std::vector<BrokenEdge>& deleted_edges
     return visited.size() != sequence.size();
 }
 
+// hash map based version of feasible(), for moves too large for FixedMove.
+bool feasible_large(const Tour& tour
+    , const std::vector<primitives::point_id_t>& starts
+    , const std::vector<primitives::point_id_t>& ends
+    , const std::vector<primitives::point_id_t>& removes) {
+    const auto deleted_edges = sorted_removes(tour, removes);
+    if (starts.size() != deleted_edges.size()) {
+        throw std::logic_error("number of deleted edges does not equal number of new edges.");
+    }
+    const auto sequence = compute_sequence(deleted_edges);
+    const auto new_edges = compute_new_edge_connectivity(starts, ends);
+
+    // traversal
+    const auto start {deleted_edges[0].first};
+    auto current {start};
+    size_t visited {0};
+    size_t max_visited {starts.size() + ends.size()};
+    std::unordered_map<primitives::point_id_t, bool> visit_flag;
+    visit_flag[current] = true;
+    std::unordered_set<primitives::point_id_t> checklist;
+    do {
+        if (sequence.find(current) == std::cend(sequence)) {
+            throw std::logic_error("point not recognized");
+        }
+        // go to next in new edge.
+        auto next = new_edges.find(current)->second.back();
+        if (new_edges.find(next)->second.size() > 2) {
+            throw std::logic_error("too many adjacent points");
+        }
+        if (visit_flag[next]) {
+            next = new_edges.find(current)->second.front();
+        }
+        current = next;
+        visit_flag[current] = true;
+        ++visited;
+        if (current == start or checklist.find(current) != std::cend(checklist)) {
+            ++visited;
+            break;
+        }
+        checklist.insert(current);
+        // find adjacent new edge start point.
+        auto index {sequence.find(current)->second};
+        const auto& edge {deleted_edges[index]};
+        if (edge.first == current) {
+            if (index == 0) {
+                index = deleted_edges.size() - 1;
+            } else {
+                --index;
+            }
+            current = deleted_edges[index].second;
+        } else {
+            ++index;
+            if (index == deleted_edges.size()) {
+                index = 0;
+            }
+            current = deleted_edges[index].first;
+        }
+        checklist.insert(current);
+        visit_flag[current] = true;
+        ++visited;
+    } while (current != start and visited < max_visited);
+    return current == start and visited == max_visited;
+}
+
+// up to MAX_K deleted edges, with their points labeled by slots into small arrays,
+// so that feasible() needs no heap allocation or hashing.
+constexpr size_t MAX_K{32};
+
+// insertion sort; faster than std::sort for the few elements here.
+template <typename T, typename Less>
+void small_sort(T *begin, T *end, const Less &less) {
+    for (auto i = begin + 1; i < end; ++i) {
+        const auto value = *i;
+        auto j = i;
+        for (; j > begin and less(value, *(j - 1)); --j) {
+            *j = *(j - 1);
+        }
+        *j = value;
+    }
+}
+
+class FixedMove {
+ public:
+    // returns false if k exceeds MAX_K.
+    bool build(const Tour &tour
+        , const std::vector<primitives::point_id_t> &starts
+        , const std::vector<primitives::point_id_t> &ends
+        , const std::vector<primitives::point_id_t> &removes) {
+        k_ = removes.size();
+        if (k_ > MAX_K) {
+            return false;
+        }
+        if (starts.size() != k_) {
+            throw std::logic_error("number of deleted edges does not equal number of new edges.");
+        }
+        // deleted edges sorted by sequence.
+        for (size_t i{0}; i < k_; ++i) {
+            edges_[i] = {removes[i], tour.next(removes[i]), tour.sequence(removes[i], removes[0])};
+        }
+        small_sort(edges_.data(), edges_.data() + k_
+            , [](const auto &lhs, const auto &rhs) { return lhs.sequence < rhs.sequence; });
+        // slot 2i is the first point of deleted edge i, slot 2i + 1 the second.
+        for (size_t i{0}; i < k_; ++i) {
+            points_[2 * i] = edges_[i].first;
+            points_[2 * i + 1] = edges_[i].second;
+        }
+        slots_ = 2 * k_;
+        // a point shared by consecutive deleted edges belongs to the later one.
+        for (size_t i{0}; i < k_; ++i) {
+            first_slot_[i] = slot(edges_[i].first);
+            second_slot_[i] = slot(edges_[i].second);
+            edge_index_[first_slot_[i]] = i;
+            edge_index_[second_slot_[i]] = i;
+        }
+        std::fill(std::begin(adjacent_count_), std::begin(adjacent_count_) + slots_, 0);
+        for (size_t i{0}; i < k_; ++i) {
+            const auto start = slot(starts[i]);
+            const auto end = slot(ends[i]);
+            add_adjacent(start, end);
+            add_adjacent(end, start);
+        }
+        return true;
+    }
+
+    // same traversal as feasible_large().
+    bool feasible() {
+        std::fill(std::begin(visit_flag_), std::begin(visit_flag_) + slots_, false);
+        std::fill(std::begin(checklist_), std::begin(checklist_) + slots_, false);
+        const auto start = first_slot_[0];
+        auto current = start;
+        size_t visited{0};
+        const size_t max_visited{2 * k_};
+        visit_flag_[current] = true;
+        do {
+            if (adjacent_count_[current] == 0) {
+                throw std::logic_error("point not recognized");
+            }
+            // go to next in new edge.
+            auto next = adjacents_[current][adjacent_count_[current] - 1];
+            if (visit_flag_[next]) {
+                next = adjacents_[current][0];
+            }
+            current = next;
+            visit_flag_[current] = true;
+            ++visited;
+            if (current == start or checklist_[current]) {
+                ++visited;
+                break;
+            }
+            checklist_[current] = true;
+            // find adjacent new edge start point.
+            auto index = edge_index_[current];
+            if (first_slot_[index] == current) {
+                index = (index == 0) ? k_ - 1 : index - 1;
+                current = second_slot_[index];
+            } else {
+                index = (index + 1 == k_) ? 0 : index + 1;
+                current = first_slot_[index];
+            }
+            checklist_[current] = true;
+            visit_flag_[current] = true;
+            ++visited;
+        } while (current != start and visited < max_visited);
+        return current == start and visited == max_visited;
+    }
+
+ private:
+    using Slot = uint8_t;
+    size_t k_{0};
+    size_t slots_{0};
+    std::array<BrokenEdge, MAX_K> edges_;
+    std::array<primitives::point_id_t, 2 * MAX_K> points_;
+    std::array<Slot, MAX_K> first_slot_;
+    std::array<Slot, MAX_K> second_slot_;
+    std::array<size_t, 2 * MAX_K> edge_index_;
+    std::array<std::array<Slot, 2>, 2 * MAX_K> adjacents_; // new edges, in insertion order.
+    std::array<uint8_t, 2 * MAX_K> adjacent_count_;
+    std::array<bool, 2 * MAX_K> visit_flag_;
+    std::array<bool, 2 * MAX_K> checklist_;
+
+    // the last slot holding point; a linear scan is fastest for so few slots.
+    Slot slot(primitives::point_id_t point) const {
+        for (auto s = slots_; s > 0; --s) {
+            if (points_[s - 1] == point) {
+                return s - 1;
+            }
+        }
+        throw std::logic_error("point not recognized");
+    }
+    void add_adjacent(Slot s, Slot adjacent) {
+        if (adjacent_count_[s] == 2) {
+            throw std::logic_error("too many adjacent points");
+        }
+        adjacents_[s][adjacent_count_[s]++] = adjacent;
+    }
+};
+
 }  // namespace
 
 bool breaks_cycle(const Tour &tour, const KMove &kmove) {
@@ -148,63 +348,11 @@ bool feasible(const Tour& tour
     , const std::vector<primitives::point_id_t>& starts
     , const std::vector<primitives::point_id_t>& ends
     , const std::vector<primitives::point_id_t>& removes) {
-    const auto deleted_edges = sorted_removes(tour, removes);
-    if (starts.size() != deleted_edges.size()) {
-        throw std::logic_error("number of deleted edges does not equal number of new edges.");
+    FixedMove move;
+    if (not move.build(tour, starts, ends, removes)) {
+        return feasible_large(tour, starts, ends, removes);
     }
-    const auto sequence = compute_sequence(deleted_edges);
-    const auto new_edges = compute_new_edge_connectivity(starts, ends);
-
-    // traversal
-    const auto start {deleted_edges[0].first};
-    auto current {start};
-    size_t visited {0};
-    size_t max_visited {starts.size() + ends.size()};
-    std::unordered_map<primitives::point_id_t, bool> visit_flag;
-    visit_flag[current] = true;
-    std::unordered_set<primitives::point_id_t> checklist;
-    do {
-        if (sequence.find(current) == std::cend(sequence)) {
-            throw std::logic_error("point not recognized");
-        }
-        // go to next in new edge.
-        auto next = new_edges.find(current)->second.back();
-        if (new_edges.find(next)->second.size() > 2) {
-            throw std::logic_error("too many adjacent points");
-        }
-        if (visit_flag[next]) {
-            next = new_edges.find(current)->second.front();
-        }
-        current = next;
-        visit_flag[current] = true;
-        ++visited;
-        if (current == start or checklist.find(current) != std::cend(checklist)) {
-            ++visited;
-            break;
-        }
-        checklist.insert(current);
-        // find adjacent new edge start point.
-        auto index {sequence.find(current)->second};
-        const auto& edge {deleted_edges[index]};
-        if (edge.first == current) {
-            if (index == 0) {
-                index = deleted_edges.size() - 1;
-            } else {
-                --index;
-            }
-            current = deleted_edges[index].second;
-        } else {
-            ++index;
-            if (index == deleted_edges.size()) {
-                index = 0;
-            }
-            current = deleted_edges[index].first;
-        }
-        checklist.insert(current);
-        visit_flag[current] = true;
-        ++visited;
-    } while (current != start and visited < max_visited);
-    return current == start and visited == max_visited;
+    return move.feasible();
 }
 
 } // namespace cycle_check
@@ -0,0 +1,102 @@
+#include "diagnostics.hh"
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <utility> // move, pair
+
+namespace diagnostics {
+
+namespace {
+
+// Writes queued files in order. Started by the first file; drains the queue before the program exits.
+class Writer {
+ public:
+    ~Writer() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        queued_.notify_one();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    void write(std::string path, std::string contents) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (not thread_.joinable()) {
+                thread_ = std::thread([this]() { run(); });
+            }
+            files_.emplace_back(std::move(path), std::move(contents));
+        }
+        queued_.notify_one();
+    }
+
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        written_.wait(lock, [this]() { return files_.empty() and not writing_; });
+    }
+
+ private:
+    std::mutex mutex_;
+    std::condition_variable queued_;
+    std::condition_variable written_;
+    std::deque<std::pair<std::string, std::string>> files_;
+    bool writing_{false};
+    bool stop_{false};
+    std::thread thread_;
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            queued_.wait(lock, [this]() { return stop_ or not files_.empty(); });
+            if (files_.empty()) {
+                return;
+            }
+            auto file = std::move(files_.front());
+            files_.pop_front();
+            writing_ = true;
+            lock.unlock();
+            std::ofstream out(file.first, std::ofstream::out | std::ofstream::trunc);
+            out << file.second;
+            out.close();
+            lock.lock();
+            writing_ = false;
+            written_.notify_all();
+        }
+    }
+};
+
+Writer &writer() {
+    static Writer writer;
+    return writer;
+}
+
+std::mutex &output_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+}  // namespace
+
+Message::~Message() {
+    text_ << '\n';
+    const auto line = text_.str();
+    std::lock_guard<std::mutex> lock(output_mutex());
+    std::cout << line << std::flush;
+}
+
+void write_file(std::string path, std::string contents) {
+    writer().write(std::move(path), std::move(contents));
+}
+
+void flush() {
+    writer().flush();
+}
+
+}  // namespace diagnostics
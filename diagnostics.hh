@@ -0,0 +1,55 @@
+#pragma once
+
+// Leveled diagnostics for the search, off the hot path when disabled:
+// callers check enabled() before formatting anything, which is one relaxed atomic load.
+//
+// Messages are single lines for standard output; each is formatted in full and written at once,
+// so lines from different threads do not mix and keep their order relative to other output.
+// Files (e.g. edge dumps) are handed to a background writer thread, which writes them buffered
+// while the search goes on.
+
+#include <atomic>
+#include <sstream>
+#include <string>
+
+namespace diagnostics {
+
+enum class Level : int {
+    OFF = 0,
+    SUMMARY = 1, // a few lines per merge.
+    DETAIL = 2, // every group and improving combo, and edge dumps in output/.
+};
+
+inline std::atomic<int> current_level{static_cast<int>(Level::SUMMARY)};
+
+inline void set_level(Level level) { current_level.store(static_cast<int>(level), std::memory_order_relaxed); }
+
+inline bool enabled(Level level) {
+    return static_cast<int>(level) <= current_level.load(std::memory_order_relaxed);
+}
+
+// A line for standard output, written when the message goes out of scope.
+class Message {
+ public:
+    Message() = default;
+    Message(const Message &) = delete;
+    Message &operator=(const Message &) = delete;
+    ~Message();
+
+    template <typename T>
+    Message &operator<<(const T &value) {
+        text_ << value;
+        return *this;
+    }
+
+ private:
+    std::ostringstream text_;
+};
+
+// Replaces the file at path with contents, on the writer thread.
+void write_file(std::string path, std::string contents);
+
+// Waits until the writer thread has written every file queued so far.
+void flush();
+
+}  // namespace diagnostics
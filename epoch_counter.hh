@@ -0,0 +1,51 @@
+#pragma once
+
+// Small per-point counters that can all be reset in O(1).
+// A count is only valid while its stamp matches the current epoch; clear() starts a new epoch.
+
+#include "primitives.hh"
+
+#include <algorithm> // fill
+#include <cstdint> // uint32_t
+#include <vector>
+
+class EpochCounter {
+ public:
+    void resize(size_t size) {
+        entries_.resize(size);
+    }
+    size_t size() const { return entries_.size(); }
+
+    uint32_t count(primitives::point_id_t i) const {
+        const auto &entry = entries_[i];
+        return (entry.epoch == epoch_) ? entry.count : 0;
+    }
+    void increment(primitives::point_id_t i) {
+        auto &entry = entries_[i];
+        if (entry.epoch != epoch_) {
+            entry = {epoch_, 0};
+        }
+        ++entry.count;
+    }
+    // i must have been incremented in the current epoch.
+    void decrement(primitives::point_id_t i) {
+        --entries_[i].count;
+    }
+
+    void clear() {
+        ++epoch_;
+        if (epoch_ == 0) {
+            // wrapped around; stale stamps could now match.
+            std::fill(std::begin(entries_), std::end(entries_), Entry{});
+            epoch_ = 1;
+        }
+    }
+
+ private:
+    struct Entry {
+        uint32_t epoch{0};
+        uint32_t count{0};
+    };
+    std::vector<Entry> entries_;
+    uint32_t epoch_{1};
+};
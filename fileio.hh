@@ -8,6 +8,7 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <utility> // move
 #include <vector>
 
 namespace fileio {
@@ -87,7 +88,27 @@ inline std::vector<primitives::point_id_t> initial_tour(primitives::point_id_t p
     return tour_file_path ? read_ordered_points(*tour_file_path) : default_tour(point_count);
 }
 
-inline std::array<std::vector<primitives::space_t>, 2> read_coordinates(const std::string &file_path)
+// a point set file (TSPLIB format).
+struct Instance {
+    std::string edge_weight_type{"EUC_2D"}; // EDGE_WEIGHT_TYPE header value.
+    std::vector<primitives::space_t> x, y;
+    std::vector<primitives::space_t> z; // only for 3D edge weight types.
+};
+
+// value of a "KEY: value" header line, without surrounding whitespace.
+inline std::string header_value(const std::string &line)
+{
+    const auto value = line.substr(line.find(':') + 1);
+    const auto begin = value.find_first_not_of(" \t\r");
+    if (begin == std::string::npos)
+    {
+        return "";
+    }
+    const auto end = value.find_last_not_of(" \t\r");
+    return value.substr(begin, end - begin + 1);
+}
+
+inline Instance read_instance(const std::string &file_path)
 {
     std::cout << "\nReading point set file: " << file_path << std::endl;
     std::ifstream file_stream(file_path);
@@ -96,6 +117,7 @@ inline std::array<std::vector<primitives::space_t>, 2> read_coordinates(const st
         std::cout << "Could not open file: " << file_path << std::endl;
         std::exit(EXIT_SUCCESS);
     }
+    Instance instance;
     size_t point_count{0};
     // header.
     std::string line;
@@ -112,15 +134,22 @@ inline std::array<std::vector<primitives::space_t>, 2> read_coordinates(const st
             point_count = std::stoi(point_count_string);
             std::cout << "Number of points according to header: " << point_count << std::endl;
         }
+        if (line.find("EDGE_WEIGHT_TYPE") != std::string::npos)
+        {
+            instance.edge_weight_type = header_value(line);
+            std::cout << "Edge weight type: " << instance.edge_weight_type << std::endl;
+        }
     }
     if (point_count == 0)
     {
         std::cout << "Could not read any points from the point set file." << std::endl;
         std::exit(EXIT_SUCCESS);
     }
+    const bool three_dimensional = instance.edge_weight_type.find("_3D") != std::string::npos;
 
     // read coordinates.
-    std::vector<primitives::space_t> x, y;
+    auto &x = instance.x;
+    auto &y = instance.y;
     while (not file_stream.eof())
     {
         if (x.size() >= point_count)
@@ -138,6 +167,11 @@ inline std::array<std::vector<primitives::space_t>, 2> read_coordinates(const st
             x.push_back(value);
             line_stream >> value;
             y.push_back(value);
+            if (three_dimensional)
+            {
+                line_stream >> value;
+                instance.z.push_back(value);
+            }
         }
         else
         {
@@ -150,7 +184,13 @@ inline std::array<std::vector<primitives::space_t>, 2> read_coordinates(const st
         }
     }
     std::cout << "Finished reading point set file.\n" << std::endl;
-    return {x, y};
+    return instance;
+}
+
+inline std::array<std::vector<primitives::space_t>, 2> read_coordinates(const std::string &file_path)
+{
+    auto instance = read_instance(file_path);
+    return {std::move(instance.x), std::move(instance.y)};
 }
 
 template <typename PairContainer>
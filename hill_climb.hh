@@ -1,18 +1,29 @@
 #pragma once
 
+#include "diagnostics.hh"
 #include "hill_climber.hh"
+#include "or_opt.hh"
 #include "point_set.hh"
 #include "primitives.hh"
 #include "tour.hh"
 
-#include <iostream>
+#include <random>
 
 namespace hill_climb {
 
-inline primitives::length_t hill_climb(const PointSet &point_set, Tour &tour, size_t kmax) {
-    HillClimber hill_climber(point_set);
-    auto kmove = hill_climber.find_best(tour, kmax);
+// Or-opt moves are much cheaper to find than general k-opt moves and fix most defects of fresh tours,
+// so they are applied first, from the points the climber has yet to search.
+template <typename Metric>
+primitives::length_t hill_climb(HillClimber<Metric> &hill_climber, Tour &tour, size_t kmax) {
+    OrOpt<Metric> or_opt(hill_climber.point_set());
+    hill_climber.changed(or_opt.optimize(tour, hill_climber.unsearched(tour)));
+    if (or_opt.moves() > 0) {
+        if (diagnostics::enabled(diagnostics::Level::SUMMARY)) {
+            diagnostics::Message() << "or-opt moves: " << or_opt.moves();
+        }
+    }
     int iterations{0};
+    auto kmove = hill_climber.find_best(tour, kmax);
     while (kmove) {
         tour.swap(*kmove);
         hill_climber.changed(*kmove);
@@ -20,21 +31,50 @@ inline primitives::length_t hill_climb(const PointSet &point_set, Tour &tour, si
         ++iterations;
     }
     const auto length = tour.length();
-    std::cout << "tour length after " << iterations << " iterations: " << length << std::endl;
+    if (diagnostics::enabled(diagnostics::Level::SUMMARY)) {
+        diagnostics::Message() << "tour length after " << iterations << " iterations: " << length;
+    }
     return length;
 }
 
-inline primitives::length_t hill_climb(HillClimber &hill_climber, Tour &tour, size_t kmax) {
-    int iterations{0};
-    auto kmove = hill_climber.find_best(tour, kmax);
-    while (kmove) {
-        tour.swap(*kmove);
-        hill_climber.changed(*kmove);
-        kmove = hill_climber.find_best(tour, kmax);
-        ++iterations;
+template <typename Metric>
+primitives::length_t hill_climb(const PointSet<Metric> &point_set, Tour &tour, size_t kmax) {
+    HillClimber<Metric> hill_climber(point_set);
+    return hill_climb(hill_climber, tour, kmax);
+}
+
+// Fast approximate descent, to run before an exhaustive hill_climb() on large instances.
+// Each round climbs with sampled neighborhoods (HillClimber::sample()), doubling the width from initial_width,
+// until a round improves the tour by less than min_improvement (relative) or the width passes max_width.
+// The result is not locally optimal; the exhaustive climb afterwards restores that.
+struct SampleSchedule {
+    size_t initial_width{2};
+    size_t max_width{16};
+    double min_improvement{0.001};
+    std::mt19937::result_type seed{0};
+};
+
+template <typename Metric>
+primitives::length_t sampled_descent(const PointSet<Metric> &point_set
+    , Tour &tour
+    , size_t kmax
+    , const SampleSchedule &schedule) {
+    auto length = tour.length();
+    auto seed = schedule.seed;
+    for (auto width = schedule.initial_width; width > 0 and width <= schedule.max_width; width *= 2) {
+        // a new climber each round, as the last one marked every point searched.
+        HillClimber<Metric> hill_climber(point_set);
+        hill_climber.sample(width, seed++);
+        const auto new_length = hill_climb(hill_climber, tour, kmax);
+        if (diagnostics::enabled(diagnostics::Level::SUMMARY)) {
+            diagnostics::Message() << "sample width " << width << ": tour length " << new_length;
+        }
+        const auto improvement = length - new_length;
+        length = new_length;
+        if (improvement < schedule.min_improvement * length) {
+            break;
+        }
     }
-    const auto length = tour.length();
-    std::cout << "tour length after " << iterations << " iterations: " << length << std::endl;
     return length;
 }
 
@@ -4,6 +4,7 @@
 #include "config.hh"
 #include "kmargin.hh"
 #include "kmove.hh"
+#include "length_calculator.hh"
 #include "tour.hh"
 #include "constants.h"
 #include "cycle_check.hh"
@@ -24,7 +25,7 @@ public:
         , m_tour(tour)
         , m_box_maker(tour.x(), tour.y())
         , m_length_calculator(tour.x(), tour.y())
-        , m_kmax(config.get<size_t>("kmax", m_kmax)) {}
+        , m_kmax(config.get<size_t>("kmax", DEFAULT_KMAX)) {}
 
     std::optional<KMove> find_best();
     std::optional<KMove> find_best(std::nullopt_t) { return find_best(); }
@@ -36,7 +37,8 @@ protected:
     Tour& m_tour;
     const BoxMaker m_box_maker;
     LengthCalculator m_length_calculator;
-    size_t m_kmax {3};
+    static constexpr size_t DEFAULT_KMAX {3};
+    size_t m_kmax {DEFAULT_KMAX};
 
     KMove m_kmove;
     primitives::point_id_t m_swap_end {constants::invalid_point};
@@ -1,13 +1,19 @@
 #pragma once
 
 #include "GenericFinder.h"
+#include "box.hh"
+#include "cell_list/grid.hh"
+#include "epoch_counter.hh"
+#include "point_quadtree/Domain.h"
+#include "segment_tracker.hh"
 
-#include <algorithm> // min, max
-#include <iterator> // next, prev
+#include <algorithm> // min, max, sort
 #include <limits>
+#include <memory> // unique_ptr
 #include <stdexcept> // logic_error
 #include <unordered_map>
 #include <unordered_set>
+#include <utility> // pair
 #include <vector>
 
 namespace hill_climb {
@@ -21,14 +27,51 @@ public:
 
     void find_best_nonsequential();
 
+    // infeasible moves collected by find_best().
+    size_t nonsequential_moves() const { return m_nonsequential_moves.size(); }
+    // combinations found by find_best_nonsequential().
+    const auto& single_cycle_moves() const { return m_single_cycle_moves; }
+    const auto& double_cycle_moves() const { return m_double_cycle_moves; }
+
 private:
+    // an infeasible move, in the form needed to combine it with others.
+    struct SplitMove
+    {
+        std::vector<primitives::sequence_t> sequences; // of each removed edge, from a fixed origin.
+        // new edges, as segment end labels of this move's removed edges.
+        std::vector<std::pair<SegmentTracker::Label, SegmentTracker::Label>> new_edges;
+        Box box; // of the removed edges.
+    };
+
     std::vector<KMove> m_nonsequential_moves;
     std::vector<KMove> m_double_cycle_moves;
     std::vector<KMove> m_single_cycle_moves;
     std::unordered_set<primitives::point_id_t> m_small_cycle;
 
-    void try_combination(const KMove& kmove, size_t kmove_cycles, std::vector<KMove>::const_iterator begin);
-    bool duplicate_remove(const KMove& kmove, const KMove& other) const;
+    // m_nonsequential_moves, bucketed by location (the center of each move's box).
+    std::vector<SplitMove> m_split_moves;
+    std::vector<primitives::space_t> m_move_x;
+    std::vector<primitives::space_t> m_move_y;
+    std::unique_ptr<point_quadtree::Domain> m_move_domain;
+    std::unique_ptr<cell_list::Grid> m_move_grid;
+    primitives::space_t m_max_move_width {0};
+    primitives::space_t m_max_move_height {0};
+
+    // the combination being tried, built up one move at a time.
+    std::vector<size_t> m_combined;
+    std::vector<Box> m_combined_box;
+    SegmentTracker m_segments;
+    EpochCounter m_combined_removes; // by point.
+
+    SplitMove split(const KMove& kmove) const;
+    void bucket_moves();
+    void push_move(size_t move);
+    void pop_move();
+    KMove combination() const;
+    bool addable(size_t move) const;
+    bool interleaves(size_t move) const;
+    std::vector<size_t> nearby_moves() const;
+    void try_combination(size_t cycles);
     // returns 0 if cost greater than gain.
     primitives::length_t net_gain(const KMove& kmove) const;
 
@@ -36,13 +79,13 @@ private:
     void try_double_cycle_merge(const KMove&);
 };
 
-void NonsequentialFinder::try_double_cycle_merge(const KMove&)
+inline void NonsequentialFinder::try_double_cycle_merge(const KMove&)
 {
     //auto new_tour = m_tour;
     //new_tour.multicycle_swap();
 }
 
-void NonsequentialFinder::print_double_cycle_stats() const
+inline void NonsequentialFinder::print_double_cycle_stats() const
 {
     std::cout << "double-cycle moves found: " << m_double_cycle_moves.size() << std::endl;
     primitives::length_t min {std::numeric_limits<primitives::length_t>::max()};
@@ -81,99 +124,216 @@ inline primitives::length_t NonsequentialFinder::net_gain(const KMove& kmove) co
     return gain - cost;
 }
 
+// Combines infeasible moves into feasible ones.
+// Combining a move can only reduce the number of cycles if its removed edges fall in at least two cycles
+// of the combination so far, so each combination is only extended with nearby moves that do.
+// Cycle counts come from the segment structure of the combination, kept up to date as moves are added and removed.
 inline void NonsequentialFinder::find_best_nonsequential()
 {
     if (m_nonsequential_moves.size() < 2)
     {
         return;
     }
-    const auto begin = std::cbegin(m_nonsequential_moves);
-    auto kmove = begin;
-    for (auto it = std::next(begin); it != std::cend(m_nonsequential_moves); ++it)
+    bucket_moves();
+    m_combined.clear();
+    m_combined_box.clear();
+    m_combined_removes.resize(m_tour.size());
+    for (size_t move {0}; move < m_split_moves.size(); ++move)
     {
-        const auto kmove_cycles = cycle_check::count_cycles(m_tour, *kmove);
-        if (kmove_cycles == 2)
+        push_move(move);
+        if (m_segments.cycles() == 2)
         {
-            m_double_cycle_moves.push_back(*kmove);
+            m_double_cycle_moves.push_back(m_nonsequential_moves[move]);
         }
-        kmove = it;
+        pop_move();
     }
     print_double_cycle_stats();
-    kmove = begin;
-    for (auto it = std::next(begin); it != std::cend(m_nonsequential_moves); ++it)
+    for (size_t move {0}; move < m_split_moves.size(); ++move)
     {
-        const auto kmove_cycles = cycle_check::count_cycles(m_tour, *kmove);
-        try_combination(*kmove, kmove_cycles, it);
+        push_move(move);
+        try_combination(m_segments.cycles());
         if (m_stop)
         {
             return;
         }
-        kmove = it;
+        pop_move();
     }
     std::cout << "nonsequential moves seen: " << m_nonsequential_moves.size() << std::endl;
     std::cout << "single-cycle moves found: " << m_single_cycle_moves.size() << std::endl;
     print_double_cycle_stats();
 }
 
-void NonsequentialFinder::try_combination(const KMove& kmove
-    , size_t kmove_cycles
-    , std::vector<KMove>::const_iterator begin)
+// cycles: number of cycles left by the current combination.
+inline void NonsequentialFinder::try_combination(size_t cycles)
 {
-    double avg_cycles {0};
-    size_t min_cycles {std::numeric_limits<size_t>::max()};
-    size_t max_cycles {0};
-    size_t tries {0};
-    for (auto it = begin; it != std::cend(m_nonsequential_moves); ++it)
+    // interleaves() reads the cycles of the current combination, which deeper combinations overwrite.
+    std::vector<size_t> candidates;
+    for (auto move : nearby_moves())
     {
-        if (duplicate_remove(kmove, *it))
+        if (move > m_combined.back() and addable(move) and interleaves(move))
         {
-            continue;
+            candidates.push_back(move);
         }
-        const auto new_kmove = kmove + *it;
-        const auto new_kmove_cycles = cycle_check::count_cycles(m_tour, new_kmove);
-        if (new_kmove_cycles <= kmove_cycles) // this threshold is quite arbitrary.
+    }
+    std::sort(std::begin(candidates), std::end(candidates));
+    for (auto move : candidates)
+    {
+        push_move(move);
+        const auto new_cycles = m_segments.cycles();
+        if (new_cycles <= cycles) // this threshold is quite arbitrary.
         {
-            if (new_kmove_cycles == 1)
+            if (new_cycles == 1)
             {
-                m_single_cycle_moves.push_back(new_kmove);
+                m_single_cycle_moves.push_back(combination());
                 m_stop = true;
                 return;
             }
-            if (new_kmove_cycles == 2)
+            if (new_cycles == 2)
             {
-                m_double_cycle_moves.push_back(new_kmove);
+                m_double_cycle_moves.push_back(combination());
             }
-            try_combination(new_kmove, new_kmove_cycles, it);
+            try_combination(new_cycles);
             if (m_stop)
             {
                 return;
             }
         }
-        avg_cycles += new_kmove_cycles;
-        min_cycles = std::min(min_cycles, new_kmove_cycles);
-        max_cycles = std::max(max_cycles, new_kmove_cycles);
-        ++tries;
+        pop_move();
     }
-    if (false and tries > 0)
+}
+
+inline NonsequentialFinder::SplitMove NonsequentialFinder::split(const KMove& kmove) const
+{
+    SplitMove split;
+    const auto k = kmove.removes.size();
+    for (auto remove : kmove.removes)
     {
-        std::cout << "min, avg, max: "
-            << min_cycles
-            << ", " << avg_cycles / tries
-            << ", " << max_cycles
-            << std::endl;
+        split.sequences.push_back(m_tour.sequence(remove, 0));
+        split.box.include(m_tour.x(remove), m_tour.y(remove));
+        const auto next = m_tour.next(remove);
+        split.box.include(m_tour.x(next), m_tour.y(next));
     }
+    // a point on two removed edges has two labels; either can take either of its new edges.
+    std::vector<bool> used(2 * k, false);
+    auto label = [&](primitives::point_id_t point)
+    {
+        for (size_t e {0}; e < k; ++e)
+        {
+            for (bool second : {false, true})
+            {
+                const auto label = SegmentTracker::label(e, second);
+                const auto end = second ? m_tour.next(kmove.removes[e]) : kmove.removes[e];
+                if (end == point and not used[label])
+                {
+                    used[label] = true;
+                    return label;
+                }
+            }
+        }
+        throw std::logic_error("new edge point is not the end of a removed edge.");
+    };
+    for (size_t i {0}; i < kmove.starts.size(); ++i)
+    {
+        const auto start = label(kmove.starts[i]);
+        split.new_edges.emplace_back(start, label(kmove.ends[i]));
+    }
+    return split;
 }
 
-inline bool NonsequentialFinder::duplicate_remove(const KMove& kmove, const KMove& other) const
+inline void NonsequentialFinder::bucket_moves()
 {
-    std::unordered_set<primitives::point_id_t> seen;
-    for (auto remove : kmove.removes)
+    m_split_moves.clear();
+    m_move_x.clear();
+    m_move_y.clear();
+    m_max_move_width = 0;
+    m_max_move_height = 0;
+    for (const auto& kmove : m_nonsequential_moves)
+    {
+        m_split_moves.push_back(split(kmove));
+        const auto& box = m_split_moves.back().box;
+        m_move_x.push_back((box.xmin + box.xmax) / 2);
+        m_move_y.push_back((box.ymin + box.ymax) / 2);
+        m_max_move_width = std::max(m_max_move_width, box.xmax - box.xmin);
+        m_max_move_height = std::max(m_max_move_height, box.ymax - box.ymin);
+    }
+    m_move_grid.reset();
+    m_move_domain = std::make_unique<point_quadtree::Domain>(m_move_x, m_move_y);
+    m_move_grid = std::make_unique<cell_list::Grid>(m_move_x, m_move_y, *m_move_domain);
+}
+
+inline void NonsequentialFinder::push_move(size_t move)
+{
+    if (m_combined.empty())
+    {
+        m_segments.clear();
+        m_combined_removes.clear();
+    }
+    const auto& split = m_split_moves[move];
+    const auto offset = SegmentTracker::label(m_segments.deleted_edges(), false);
+    for (size_t e {0}; e < split.sequences.size(); ++e)
+    {
+        m_segments.delete_edge(split.sequences[e]);
+        m_combined_removes.increment(m_nonsequential_moves[move].removes[e]);
+    }
+    for (const auto& [a, b] : split.new_edges)
     {
-        seen.insert(remove);
+        m_segments.add_edge(offset + a, offset + b);
     }
-    for (auto remove : other.removes)
+    auto box = m_combined_box.empty() ? Box{} : m_combined_box.back();
+    box.include(split.box);
+    m_combined_box.push_back(box);
+    m_combined.push_back(move);
+}
+
+inline void NonsequentialFinder::pop_move()
+{
+    const auto move = m_combined.back();
+    const auto& split = m_split_moves[move];
+    for (size_t i {0}; i < split.new_edges.size(); ++i)
+    {
+        m_segments.pop_added_edge();
+    }
+    for (auto remove : m_nonsequential_moves[move].removes)
+    {
+        m_segments.pop_deleted_edge();
+        m_combined_removes.decrement(remove);
+    }
+    m_combined_box.pop_back();
+    m_combined.pop_back();
+}
+
+inline KMove NonsequentialFinder::combination() const
+{
+    KMove kmove;
+    for (auto move : m_combined)
+    {
+        kmove += m_nonsequential_moves[move];
+    }
+    return kmove;
+}
+
+// false if the move removes an edge the combination already removes.
+inline bool NonsequentialFinder::addable(size_t move) const
+{
+    for (auto remove : m_nonsequential_moves[move].removes)
     {
-        if (seen.find(remove) != std::cend(seen))
+        if (m_combined_removes.count(remove) > 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// true if the move removes edges from at least two cycles of the current combination,
+// as numbered by the last call to m_segments.cycles().
+inline bool NonsequentialFinder::interleaves(size_t move) const
+{
+    const auto& sequences = m_split_moves[move].sequences;
+    const auto cycle = m_segments.segment_cycle(m_segments.segment(sequences.front()));
+    for (auto sequence : sequences)
+    {
+        if (m_segments.segment_cycle(m_segments.segment(sequence)) != cycle)
         {
             return true;
         }
@@ -181,6 +341,24 @@ inline bool NonsequentialFinder::duplicate_remove(const KMove& kmove, const KMov
     return false;
 }
 
+// moves whose boxes touch the box of the current combination.
+inline std::vector<size_t> NonsequentialFinder::nearby_moves() const
+{
+    const auto& box = m_combined_box.back();
+    Box query;
+    query.include(box.xmin - m_max_move_width / 2, box.ymin - m_max_move_height / 2);
+    query.include(box.xmax + m_max_move_width / 2, box.ymax + m_max_move_height / 2);
+    std::vector<size_t> moves;
+    for (auto move : m_move_grid->get_points(m_combined.back(), query))
+    {
+        if (m_split_moves[move].box.touches(box))
+        {
+            moves.push_back(move);
+        }
+    }
+    return moves;
+}
+
 inline void NonsequentialFinder::final_move_check()
 {
     if (cycle_check::feasible(m_tour, m_kmove))
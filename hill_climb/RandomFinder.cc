@@ -32,8 +32,8 @@ RandomFinder::search_neighborhood(primitives::point_id_t p)
     {
         return filtered;
     }
-    static std::random_device device; // will be used to obtain a seed for the random number engine
-    static std::mt19937 generator(device()); // standard mersenne_twister_engine seeded with random_device.
+    thread_local std::random_device device; // will be used to obtain a seed for the random number engine
+    thread_local std::mt19937 generator(device()); // standard mersenne_twister_engine seeded with random_device.
     std::shuffle(std::begin(filtered), std::end(filtered), generator);
     filtered.resize(samples);
     return filtered;
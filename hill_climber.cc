@@ -1,7 +1,11 @@
 #include "hill_climber.hh"
-#include "multi_box.hh"
 
-void HillClimber::changed(const KMove &kmove) {
+#include <algorithm> // max, min, partial_sort
+#include <array>
+#include <utility> // swap
+
+template <typename Metric>
+void HillClimber<Metric>::changed(const KMove &kmove) {
     MultiBox changed;
     for (size_t k{0}; k < kmove.starts.size(); ++k) {
         const auto &new_start = kmove.starts[k];
@@ -9,6 +13,23 @@ void HillClimber::changed(const KMove &kmove) {
         const auto &new_end = kmove.ends[k];
         changed.include(m_tour->x(new_end), m_tour->y(new_end));
     }
+    invalidate(changed);
+}
+
+template <typename Metric>
+void HillClimber<Metric>::changed(const std::vector<primitives::point_id_t> &points) {
+    if (search_extents_.empty()) {
+        return; // nothing searched yet.
+    }
+    MultiBox changed;
+    for (auto p : points) {
+        changed.include(m_tour->x(p), m_tour->y(p));
+    }
+    invalidate(changed);
+}
+
+template <typename Metric>
+void HillClimber<Metric>::invalidate(const MultiBox &changed) {
     for (primitives::point_id_t i{0}; i < m_tour->size(); ++i) {
         if (not search_extents_[i]) {
             continue;
@@ -20,27 +41,304 @@ void HillClimber::changed(const KMove &kmove) {
     }
 }
 
-void HillClimber::final_move_check() {
-    if (cycle_check::feasible(*m_tour, m_kmove)) {
+template <typename Metric>
+std::vector<primitives::point_id_t> HillClimber<Metric>::unsearched(const Tour &tour) const {
+    std::vector<primitives::point_id_t> points;
+    for (primitives::point_id_t i{0}; i < tour.size(); ++i) {
+        if (search_extents_.empty() or not search_extents_[i]) {
+            points.push_back(i);
+        }
+    }
+    return points;
+}
+
+template <typename Metric>
+void HillClimber<Metric>::final_move_check() {
+    const auto last = m_kmove.current_k() - 1;
+    update_segments();
+    const auto closing_start = label(last, m_kmove.starts.back());
+    const auto closing_end = label(0, m_swap_end);
+    if (segments_.closes(closing_start, closing_end)
+        or (segments_.cycles(closing_start, closing_end) == 2 and patch_cycles())) {
         search_extents_[m_kmove.starts.front()] = std::nullopt;
         m_stop = true;
     }
 }
 
-bool HillClimber::final_new_edge() const {
+// The closed move splits the tour into two cycles. Try to join them with a 2-exchange of positive total gain
+// (as LKH's gain23): delete a tour edge (p, x) from the smaller cycle and a tour edge (r, y) from the other,
+// and add (p, r) and (x, y). This finds non-sequential moves like the double bridge.
+// Every point of the smaller cycle is searched, so only small cycles are patched.
+template <typename Metric>
+bool HillClimber<Metric>::patch_cycles() {
+    const auto segments = segments_.segments();
+    std::array<size_t, 2> cycle_size{0, 0};
+    for (size_t s{0}; s < segments; ++s) {
+        const auto first = segment_first(s);
+        cycle_size[segments_.segment_cycle(s)] += m_tour->sequence(segment_last(s), first) + 1;
+    }
+    const size_t small = (cycle_size[0] <= cycle_size[1]) ? 0 : 1;
+    if (cycle_size[small] > MAX_PATCH_CYCLE) {
+        return false;
+    }
+    for (size_t s{0}; s < segments; ++s) {
+        if (segments_.segment_cycle(s) != small) {
+            continue;
+        }
+        const auto first = segment_first(s);
+        const auto last = segment_last(s);
+        for (auto p = first; ; p = next(p)) {
+            if (patch_cycles(p, s, small)) {
+                return true;
+            }
+            if (p == last) {
+                break;
+            }
+        }
+    }
+    return false;
+}
+
+// tries the tour edges of p (in segment s of cycle small) that the move keeps.
+template <typename Metric>
+bool HillClimber<Metric>::patch_cycles(primitives::point_id_t p, size_t s, size_t small) {
+    const auto gain = m_kmargin.total_margin;
+    std::array<primitives::point_id_t, 2> xs{constants::invalid_point, constants::invalid_point};
+    primitives::length_t longest{0};
+    if (p != segment_first(s)) {
+        xs[0] = prev(p);
+        longest = m_tour->prev_length(p);
+    }
+    if (p != segment_last(s)) {
+        xs[1] = next(p);
+        longest = std::max(longest, length(p));
+    }
+    if (xs[0] == constants::invalid_point and xs[1] == constants::invalid_point) {
+        return false;
+    }
+    // gain criterion: the new edge (p, r) is shorter than the gain so far.
+    const auto box = m_point_set.get_box(p, gain + longest);
+    search_extents_[m_kmove.starts.front()]->include(box);
+    for (const auto r : m_point_set.get_points(p, box)) {
+        const auto r_segment = segments_.segment(m_tour->sequence(r, m_kmove.starts.front()));
+        if (segments_.segment_cycle(r_segment) == small) {
+            continue;
+        }
+        const auto pr = length(p, r);
+        std::array<primitives::point_id_t, 2> ys{constants::invalid_point, constants::invalid_point};
+        if (r != segment_first(r_segment)) {
+            ys[0] = prev(r);
+        }
+        if (r != segment_last(r_segment)) {
+            ys[1] = next(r);
+        }
+        for (const auto x : xs) {
+            if (x == constants::invalid_point) {
+                continue;
+            }
+            const auto px = length(p, x);
+            if (pr >= gain + px) {
+                continue;
+            }
+            for (const auto y : ys) {
+                if (y == constants::invalid_point) {
+                    continue;
+                }
+                const auto ry = length(r, y);
+                if (pr + length(x, y) >= gain + px + ry) {
+                    continue;
+                }
+                m_kmove.removes.push_back((x == next(p)) ? p : x);
+                m_kmove.removes.push_back((y == next(r)) ? r : y);
+                m_kmove.starts.push_back(p);
+                m_kmove.ends.push_back(r);
+                m_kmove.starts.push_back(x);
+                m_kmove.ends.push_back(y);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+template <typename Metric>
+primitives::point_id_t HillClimber<Metric>::segment_first(size_t segment) const {
+    return next(m_kmove.removes[segments_.deleted_edge(segment)]);
+}
+
+template <typename Metric>
+primitives::point_id_t HillClimber<Metric>::segment_last(size_t segment) const {
+    return m_kmove.removes[segments_.deleted_edge((segment + 1) % segments_.segments())];
+}
+
+template <typename Metric>
+bool HillClimber<Metric>::final_new_edge() const {
     return m_kmove.current_k() == m_kmax;
 }
 
-std::vector<primitives::point_id_t> HillClimber::search_neighborhood(primitives::point_id_t p) {
+// point is one of the two points of the deleted edge.
+template <typename Metric>
+SegmentTracker::Label HillClimber<Metric>::label(size_t deleted_edge, primitives::point_id_t point) const {
+    return SegmentTracker::label(deleted_edge, point != m_kmove.removes[deleted_edge]);
+}
+
+template <typename Metric>
+void HillClimber<Metric>::push_start(primitives::point_id_t start) {
+    m_kmove.starts.push_back(start);
+    start_count_.increment(start);
+}
+
+template <typename Metric>
+void HillClimber<Metric>::pop_start() {
+    start_count_.decrement(m_kmove.starts.back());
+    m_kmove.starts.pop_back();
+}
+
+template <typename Metric>
+void HillClimber<Metric>::push_end(primitives::point_id_t end) {
+    m_kmove.ends.push_back(end);
+    end_count_.increment(end);
+}
+
+template <typename Metric>
+void HillClimber<Metric>::pop_end() {
+    end_count_.decrement(m_kmove.ends.back());
+    m_kmove.ends.pop_back();
+}
+
+template <typename Metric>
+void HillClimber<Metric>::delete_edge(primitives::point_id_t edge_start) {
+    m_kmove.removes.push_back(edge_start);
+    removed_count_.increment(edge_start);
+    m_kmargin.increase(length(edge_start));
+}
+
+template <typename Metric>
+void HillClimber<Metric>::pop_deleted_edge() {
+    removed_count_.decrement(m_kmove.removes.back());
+    m_kmove.removes.pop_back();
+    m_kmargin.pop_increase();
+    if (segments_.deleted_edges() > m_kmove.removes.size()) {
+        if (segments_.deleted_edges() > 1) {
+            segments_.pop_added_edge();
+        }
+        segments_.pop_deleted_edge();
+    }
+}
+
+// Most partial moves are extended or abandoned without a closing check,
+// so the segment tracker is only brought up to date with m_kmove when one is made.
+// Deleted edge e > 0 comes with the new edge from the previous start to the end next to it.
+template <typename Metric>
+void HillClimber<Metric>::update_segments() {
+    for (auto e = segments_.deleted_edges(); e < m_kmove.removes.size(); ++e) {
+        segments_.delete_edge(m_tour->sequence(m_kmove.removes[e], m_kmove.starts.front()));
+        if (e > 0) {
+            segments_.add_edge(label(e - 1, m_kmove.starts[e - 1]), label(e, m_kmove.ends[e - 1]));
+        }
+    }
+}
+
+// Closing a partial move back to m_swap_end leaves some number of cycles.
+// Each further step (one more deleted edge and new edge) changes that number by at most one,
+// and a final two cycles may still be joined by patch_cycles(),
+// so the branch is hopeless if the cycles outnumber the remaining steps plus two.
+template <typename Metric>
+bool HillClimber<Metric>::closable() {
+    const auto k = m_kmove.current_k();
+    const auto remaining = m_kmax - k;
+    // k deleted edges leave at most k cycles.
+    if (k <= remaining + 2) {
+        return true;
+    }
+    update_segments();
+    return segments_.cycles(label(k - 1, m_kmove.starts.back()), label(0, m_swap_end)) <= remaining + 2;
+}
+
+template <typename Metric>
+Box HillClimber<Metric>::extend_search(primitives::point_id_t p) {
     const auto search_radius = m_kmargin.total_margin + 1;
     const auto &box = m_point_set.get_box(p, search_radius);
     search_extents_[m_kmove.starts.front()]->include(box);
-    return m_point_set.get_points(p, box);
+    return box;
+}
+
+template <typename Metric>
+std::vector<primitives::point_id_t> HillClimber<Metric>::search_neighborhood(primitives::point_id_t p) {
+    return m_point_set.get_points(p, extend_search(p));
+}
+
+template <typename Metric>
+void HillClimber<Metric>::sample(size_t width, std::mt19937::result_type seed) {
+    sample_width_ = width;
+    generator_.seed(seed);
 }
 
-std::optional<KMove> HillClimber::find_best(const Tour &tour, size_t kmax) {
+// Deeper levels have exponentially more nodes, so they are sampled more narrowly.
+template <typename Metric>
+size_t HillClimber<Metric>::sample_candidates(size_t depth
+    , primitives::point_id_t *points
+    , primitives::length_t *lengths
+    , size_t count) {
+    auto width = sample_width_;
+    for (size_t d{0}; d < depth and width > 1; ++d) {
+        width /= 2;
+    }
+    if (count <= width) {
+        return count;
+    }
+    // partial Fisher-Yates shuffle.
+    for (size_t i{0}; i < width; ++i) {
+        const auto j = std::uniform_int_distribution<size_t>(i, count - 1)(generator_);
+        std::swap(points[i], points[j]);
+        std::swap(lengths[i], lengths[j]);
+    }
+    return width;
+}
+
+template <typename Metric>
+size_t HillClimber<Metric>::limit_breadth(size_t depth
+    , primitives::point_id_t *points
+    , primitives::length_t *lengths
+    , size_t count) {
+    const auto breadth = breadth_[std::min(depth, breadth_.size() - 1)];
+    if (breadth == 0 or count <= breadth) {
+        return count;
+    }
+    // best partial gain first: the new edge to p, less the longer tour edge at p that the next step can delete.
+    auto &ranked = ranked_[depth];
+    ranked.resize(count);
+    for (size_t c{0}; c < count; ++c) {
+        const auto p = points[c];
+        const auto longest = std::max(m_tour->length(p), m_tour->prev_length(p));
+        ranked[c] = {static_cast<std::int64_t>(lengths[c]) - static_cast<std::int64_t>(longest), c};
+    }
+    std::partial_sort(std::begin(ranked), std::begin(ranked) + breadth, std::end(ranked));
+    auto &selected = selected_[depth];
+    selected.clear();
+    for (size_t r{0}; r < breadth; ++r) {
+        const auto c = ranked[r].second;
+        selected.emplace_back(points[c], lengths[c]);
+    }
+    for (size_t r{0}; r < breadth; ++r) {
+        points[r] = selected[r].first;
+        lengths[r] = selected[r].second;
+    }
+    return breadth;
+}
+
+template <typename Metric>
+std::optional<KMove> HillClimber<Metric>::find_best(const Tour &tour, size_t kmax) {
     if (search_extents_.empty()) {
         search_extents_.resize(tour.size());
+        start_count_.resize(tour.size());
+        end_count_.resize(tour.size());
+        removed_count_.resize(tour.size());
+    }
+    if (candidate_lengths_.size() < kmax) {
+        candidate_lengths_.resize(kmax);
+        ranked_.resize(kmax);
+        selected_.resize(kmax);
     }
     m_tour = &tour;
     m_kmax = kmax;
@@ -57,104 +355,147 @@ std::optional<KMove> HillClimber::find_best(const Tour &tour, size_t kmax) {
     return std::nullopt;
 }
 
-void HillClimber::search(primitives::point_id_t i) {
-    m_kmove.starts.push_back(i);
+template <typename Metric>
+void HillClimber<Metric>::search(primitives::point_id_t i) {
+    push_start(i);
     search_extents_[i] = std::make_optional<Box>();
     const std::array<primitives::point_id_t, 2> back_pair {prev(i), prev(i)};
     const std::array<primitives::point_id_t, 2> front_pair {i, next(i)};
     for(auto [edge, swap_end] : {back_pair, front_pair}) {
-        m_kmove.removes.push_back(edge);
-        m_kmargin.increase(length(edge));
+        delete_edge(edge);
         m_swap_end = swap_end;
         try_nearby_points();
         if (m_stop) {
             return;
         }
-        m_kmove.removes.pop_back();
-        m_kmargin.pop_increase();
+        pop_deleted_edge();
     }
-    m_kmove.starts.pop_back();
+    pop_start();
 }
 
-void HillClimber::try_nearby_points() {
+template <typename Metric>
+void HillClimber<Metric>::try_nearby_points() {
     const auto start = m_kmove.starts.back();
-    for (auto p : search_neighborhood(start))
-    {
-        // check easy exclusion cases.
-        const bool old_edge {p == next(start) or p == prev(start)};
+    auto points = search_neighborhood(start);
+    // the margin is the same for every candidate, so filter out candidates that cannot decrease it in bulk.
+    // The exclusions go here too, so sampling and breadth limits only choose among candidates that can be tried.
+    auto &lengths = candidate_lengths_[m_kmove.starts.size() - 1];
+    lengths.resize(points.size());
+    m_point_set.length(start, points.data(), points.size(), lengths.data());
+    const auto backtrack = m_kmove.ends.empty() ? constants::invalid_point : m_kmove.ends.back();
+    size_t kept{0};
+    for (size_t c{0}; c < points.size(); ++c) {
+        const auto p = points[c];
         const bool self {p == start};
-        const bool backtrack {(not m_kmove.ends.empty()) and p == m_kmove.ends.back()};
-        if (backtrack or self or old_edge) {
+        const bool old_edge {p == next(start) or p == prev(start)};
+        if (lengths[c] >= m_kmargin.total_margin or self or old_edge or p == backtrack or end_count_.count(p) >= 2) {
             continue;
         }
-
-        // check if worth considering.
-        if (m_kmargin.decrease(length(start, p))) {
-            if (m_kmove.endable(p)) {
-                m_kmove.ends.push_back(p);
-                // check if closing swap.
-                if (p == m_swap_end) {
-                    final_move_check();
-                    if (m_stop) {
-                        return;
-                    }
-                }
-                delete_both_edges();
+        // p must close the move or have a tour edge that delete_both_edges() can delete.
+        const bool extendable {p == m_swap_end
+            or (removed_count_.count(prev(p)) == 0 and start_count_.count(prev(p)) < 2)
+            or (removed_count_.count(p) == 0 and start_count_.count(next(p)) < 2)};
+        if (not extendable) {
+            continue;
+        }
+        points[kept] = p;
+        lengths[kept] = lengths[c];
+        ++kept;
+    }
+    if (sample_width_ > 0) {
+        kept = sample_candidates(m_kmove.starts.size() - 1, points.data(), lengths.data(), kept);
+    }
+    if (not breadth_.empty() and m_kmax > 3) {
+        kept = limit_breadth(m_kmove.starts.size() - 1, points.data(), lengths.data(), kept);
+    }
+    for (size_t c{0}; c < kept; ++c)
+    {
+        const auto p = points[c];
+        if (m_kmargin.decrease(lengths[c])) {
+            push_end(p);
+            // check if closing swap.
+            if (p == m_swap_end) {
+                final_move_check();
                 if (m_stop) {
                     return;
                 }
-                m_kmove.ends.pop_back();
             }
+            delete_both_edges();
+            if (m_stop) {
+                return;
+            }
+            pop_end();
             m_kmargin.pop_decrease();
         }
     }
 }
 
-void HillClimber::delete_both_edges() {
+template <typename Metric>
+void HillClimber<Metric>::delete_both_edges() {
     const auto i = m_kmove.ends.back();
     const std::array<primitives::point_id_t, 2> back_pair {prev(i), prev(i)};
     const std::array<primitives::point_id_t, 2> front_pair {i, next(i)};
     for(auto [edge, start] : {back_pair, front_pair}) {
-        if (not m_kmove.removable(edge) or not m_kmove.startable(start)) {
+        if (removed_count_.count(edge) > 0 or start_count_.count(start) > 1) {
             continue;
         }
-        m_kmove.starts.push_back(start);
-        m_kmove.removes.push_back(edge);
-        m_kmargin.increase(length(edge));
+        push_start(start);
+        delete_edge(edge);
         if (final_new_edge()) {
             if (m_kmargin.decrease(length(start, m_swap_end))) {
-                m_kmove.ends.push_back(m_swap_end);
+                push_end(m_swap_end);
                 final_move_check();
                 if (m_stop) {
                     return;
                 }
-                m_kmove.ends.pop_back();
+                pop_end();
                 m_kmargin.pop_decrease();
             }
-        } else {
+        } else if (closable()) {
             try_nearby_points();
             if (m_stop) {
                 return;
             }
+        } else {
+            // the neighborhood was not searched, but is still in the search extent:
+            // changes there may make the branch closable.
+            extend_search(start);
         }
-        m_kmove.starts.pop_back();
-        m_kmove.removes.pop_back();
-        m_kmargin.pop_increase();
+        pop_start();
+        pop_deleted_edge();
     }
 }
 
-void HillClimber::reset_search() {
+template <typename Metric>
+void HillClimber<Metric>::reset_search() {
     m_kmove.clear();
     m_kmargin.clear();
+    segments_.clear();
+    start_count_.clear();
+    end_count_.clear();
+    removed_count_.clear();
     m_swap_end = constants::invalid_point;
     m_stop = false;
 }
 
-primitives::length_t HillClimber::length(primitives::point_id_t a, primitives::point_id_t b) const {
+template <typename Metric>
+primitives::length_t HillClimber<Metric>::length(primitives::point_id_t a, primitives::point_id_t b) const {
     return m_point_set.length(a, b);
 }
 
-primitives::length_t HillClimber::length(primitives::point_id_t edge_start) const {
-    return m_point_set.length(edge_start, next(edge_start));
+template <typename Metric>
+primitives::length_t HillClimber<Metric>::length(primitives::point_id_t edge_start) const {
+    return m_tour->length(edge_start);
 }
 
+
+template class HillClimber<metric::Euc2d>;
+template class HillClimber<metric::Ceil2d>;
+template class HillClimber<metric::Att>;
+template class HillClimber<metric::Geo>;
+template class HillClimber<metric::Euc3d>;
+template class HillClimber<metric::Matrix<metric::Euc2d>>;
+template class HillClimber<metric::Matrix<metric::Ceil2d>>;
+template class HillClimber<metric::Matrix<metric::Att>>;
+template class HillClimber<metric::Matrix<metric::Geo>>;
+template class HillClimber<metric::Matrix<metric::Euc3d>>;
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cstdint> // int64_t
 #include <optional>
+#include <random>
+#include <utility> // move, pair
 #include <vector>
 
 #include "tour.hh"
@@ -8,16 +11,40 @@
 #include "point_set.hh"
 #include "kmove.hh"
 #include "kmargin.hh"
-#include "cycle_check.hh"
+#include "segment_tracker.hh"
+#include "epoch_counter.hh"
+#include "multi_box.hh"
 
+// Metric is one of the policies in metric.hh; hill_climber.cc instantiates all of them.
+template <typename Metric>
 class HillClimber
 {
  public:
-    HillClimber(const PointSet& point_set) : m_point_set(point_set) {}
+    HillClimber(const PointSet<Metric>& point_set) : m_point_set(point_set) {}
 
     std::optional<KMove> find_best(const Tour &tour, size_t kmax);
+    // changed() reads point coordinates from the tour of the last find_best(), which a copy shares with the original;
+    // a copy for another tour (e.g. on another thread) must be pointed at it before changed() is called.
+    void set_tour(const Tour &tour) { m_tour = &tour; }
 
     void changed(const KMove &kmove);
+    // points: points whose tour neighbors changed.
+    void changed(const std::vector<primitives::point_id_t> &points);
+    // points that the next find_best() will search from.
+    std::vector<primitives::point_id_t> unsearched(const Tour &tour) const;
+
+    const PointSet<Metric> &point_set() const { return m_point_set; }
+
+    // Samples neighborhoods instead of searching them exhaustively, for a fast approximate descent
+    // (see hill_climb::sampled_descent()). At search depth d, at most max(1, width / 2^d) random candidates
+    // that satisfy the gain criterion are tried. Width 0 (the default) tries all of them.
+    // Each climber has its own generator, so climbers on different threads sample independently.
+    void sample(size_t width, std::mt19937::result_type seed);
+
+    // Limits the candidates tried at search depth d to the breadth[d] most promising ones
+    // (the last limit applies to deeper levels too; 0 is no limit). Empty (the default) searches exhaustively.
+    // Ignored for kmax <= 3, where exhaustive search keeps every sequential move, as the readme promises.
+    void set_breadth(std::vector<size_t> breadth) { breadth_ = std::move(breadth); }
 
 private:
     size_t m_kmax {3};
@@ -27,6 +54,13 @@ private:
     bool m_stop {false};
 
     KMargin m_kmargin;
+    SegmentTracker segments_;
+    // occurrences of each point in m_kmove.starts, m_kmove.ends and m_kmove.removes.
+    EpochCounter start_count_;
+    EpochCounter end_count_;
+    EpochCounter removed_count_;
+
+    void invalidate(const MultiBox &changed);
 
     void search(primitives::point_id_t i);
     void delete_both_edges();
@@ -40,10 +74,40 @@ private:
     void final_move_check();
     bool final_new_edge() const;
 
+    // largest cycle that patch_cycles() joins back into the tour.
+    static constexpr size_t MAX_PATCH_CYCLE{50};
+    bool patch_cycles();
+    bool patch_cycles(primitives::point_id_t p, size_t segment, size_t small_cycle);
+    primitives::point_id_t segment_first(size_t segment) const;
+    primitives::point_id_t segment_last(size_t segment) const;
+
+    SegmentTracker::Label label(size_t deleted_edge, primitives::point_id_t point) const;
+    void push_start(primitives::point_id_t start);
+    void pop_start();
+    void push_end(primitives::point_id_t end);
+    void pop_end();
+    void delete_edge(primitives::point_id_t edge_start);
+    void pop_deleted_edge();
+    void update_segments();
+    bool closable();
+
+    Box extend_search(primitives::point_id_t p);
     std::vector<primitives::point_id_t> search_neighborhood(primitives::point_id_t p);
 
+    std::vector<size_t> breadth_;
+    // per search depth, reused across calls: (rank, candidate index) and the selected (point, length) candidates.
+    std::vector<std::vector<std::pair<std::int64_t, size_t>>> ranked_;
+    std::vector<std::vector<std::pair<primitives::point_id_t, primitives::length_t>>> selected_;
+    // moves the most promising candidates to the front and returns how many to try.
+    size_t limit_breadth(size_t depth, primitives::point_id_t *points, primitives::length_t *lengths, size_t count);
+
+    size_t sample_width_{0};
+    std::mt19937 generator_;
+    // moves a sample of the count candidates to the front and returns the sample size.
+    size_t sample_candidates(size_t depth, primitives::point_id_t *points, primitives::length_t *lengths, size_t count);
+
     const Tour *m_tour{nullptr};
-    const PointSet &m_point_set;
+    const PointSet<Metric> &m_point_set;
 
     primitives::sequence_t size() const {
         return m_tour->size();
@@ -56,5 +120,7 @@ private:
     }
 
     std::vector<std::optional<Box>> search_extents_;
+    // candidate lengths for each search depth, reused across calls.
+    std::vector<std::vector<primitives::length_t>> candidate_lengths_;
 };
 
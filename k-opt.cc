@@ -1,69 +1,49 @@
 #include "NanoTimer.h"
 #include "check.hh"
 #include "config.hh"
+#include "diagnostics.hh"
 #include "fileio.hh"
 #include "hill_climb.hh"
 #include "hill_climber.hh"
 #include "merge/merge.hh"
+#include "metric.hh"
 #include "perturb.hh"
 #include "point_quadtree/Domain.h"
-#include "point_quadtree/point_quadtree.h"
 #include "randomize/double_bridge.h"
+#include "seen_tours.hh"
+#include "spatial_index.hh"
 #include "tour.hh"
 #include "multicycle_tour.hh"
+#include "parallel.hh"
 #include "two_short.hh"
 
+#include <algorithm> // max
 #include <filesystem>
 #include <iostream>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <thread>
+#include <utility> // move
+#include <vector>
 
-int main(int argc, const char** argv)
-{
-    if (argc == 1) {
-        std::cout << "Arguments: config_file_path" << std::endl;
-    }
-    // Read config file.
-    const std::string config_path = (argc == 1) ? "config.txt" : argv[1];
-    std::cout << "Reading config file: " << config_path << std::endl;
-    Config config(config_path);
-
-    // Read input files.
-    const std::optional<std::string> tsp_file_path_string = config.get("tsp_file_path");
-    if (not tsp_file_path_string) {
-        std::cout << "tsp_file_path not specified.\n";
-        return EXIT_FAILURE;
-    }
-    const std::optional<std::filesystem::path> tsp_file_path(*tsp_file_path_string);
-    const auto [x, y] = fileio::read_coordinates(*tsp_file_path_string);
-    const auto initial_tour = fileio::initial_tour(x.size(), config.get("tour_file_path"));
-
-    // Initial tour length calculation.
-    point_quadtree::Domain domain(x, y);
-    std::cout << "domain aspect ratio: " << domain.xdim(0) / domain.ydim(0) << std::endl;
-    std::cout << "bounding x, y dim: "
-        << domain.xdim(0) << ", " << domain.ydim(0)
-        << std::endl;
+namespace {
 
-    Tour tour(&domain, initial_tour);
+template <typename Metric>
+int run(const Config &config
+    , const Metric &metric
+    , const point_quadtree::Domain &domain
+    , const std::vector<primitives::point_id_t> &initial_tour
+    , const SpatialIndex &spatial_index
+    , const std::filesystem::path &tsp_file_path)
+{
+    Tour tour(&domain, initial_tour, metric);
     const auto initial_tour_length = tour.length();
     std::cout << "Initial tour length: " << initial_tour_length << std::endl;
 
-    // Quad tree.
-    NanoTimer timer;
-    timer.start();
-
-    std::cout << "\nquadtree stats:\n";
-    const auto root {point_quadtree::make_quadtree(x, y, domain)};
-    std::cout << "node ratio: "
-        << static_cast<double>(point_quadtree::count_nodes(root))
-            / point_quadtree::count_points(root)
-        << std::endl;
-    std::cout << "Finished quadtree in " << timer.stop() / 1e9 << " seconds.\n\n";
-
     auto best_length = initial_tour_length;
 
-    const auto &save_prefix = tsp_file_path->stem().string();
+    const auto &save_prefix = tsp_file_path.stem().string();
     const auto &save_dir_string = config.get("save_dir");
     std::optional<std::filesystem::path> save_dir;
     if (save_dir_string) {
@@ -85,12 +65,21 @@ int main(int argc, const char** argv)
         }
     };
 
-    PointSet point_set(root, x, y);
+    PointSet point_set(spatial_index, metric);
 
     // hill climb from initial tour.
     HillClimber hill_climber(point_set);
     const auto &kmax = config.get<size_t>("kmax", 3);
     std::cout << "kmax: " << kmax << std::endl;
+    hill_climber.set_breadth(config.get_sizes("breadth"));
+    const auto &sample_width = config.get<size_t>("sample_width", 0);
+    if (sample_width > 0) {
+        hill_climb::SampleSchedule schedule;
+        schedule.initial_width = sample_width;
+        schedule.max_width = config.get<size_t>("sample_max_width", schedule.max_width);
+        schedule.seed = config.get<size_t>("sample_seed", schedule.seed);
+        hill_climb::sampled_descent(point_set, tour, kmax, schedule);
+    }
     auto new_length = hill_climb::hill_climb(hill_climber, tour, kmax);
     if (new_length < best_length) {
         best_length = new_length;
@@ -130,17 +119,119 @@ int main(int argc, const char** argv)
     size_t local_optima{1};
     const auto &kmax_kswap = config.get<size_t>("kmax_kswap", 10);
     std::cout << "kmax_kswap: " << kmax_kswap << std::endl;
-    do {
-        //const auto new_tour = perturb::perturb(hill_climber, tour, kmax);
+    diagnostics::set_level(static_cast<diagnostics::Level>(config.get<size_t>("diagnostics", 1)));
+    merge::CombinatorBudget merge_budget;
+    merge_budget.max_nodes = config.get<size_t>("merge_max_nodes", merge_budget.max_nodes);
+    merge_budget.max_seconds = config.get<double>("merge_max_seconds", merge_budget.max_seconds);
+    merge::Pool pool(config.get<size_t>("pool_size", 0));
+    std::cout << "pool_size: " << pool.capacity() << std::endl;
+    const auto seen_tours = config.get<size_t>("seen_tours", 1 << 16);
+    SeenTours seen(seen_tours);
+    size_t repeats{0};
+    // perturbs current, climbs, and merges the result into current (directly or through parents), then climbs again.
+    const auto perturb_and_merge = [&](auto &climber, Tour &current, merge::Pool &parents, SeenTours &seen_before, size_t &repeated) {
+        //const auto new_tour = perturb::perturb(climber, current, kmax);
         //const auto new_tour = perturb::random_restart(point_set, &domain, kmax);
-        //const auto new_tour = perturb::random_section(hill_climber, tour, kmax, 0.05);
-        const auto new_tour = perturb::kswap(hill_climber, tour, kmax, kmax_kswap);
+        //const auto new_tour = perturb::random_section(climber, current, kmax, 0.05);
+        const auto new_tour = perturb::kswap(climber, current, kmax, kmax_kswap);
         check::check_tour(new_tour);
-        const auto kmove = merge::merge(tour, new_tour);
+        // the current tour is seen too, so perturbations that climb back to it are skipped.
+        seen_before.insert(current.hash());
+        std::optional<KMove> kmove;
+        if (not seen_before.insert(new_tour.hash())) {
+            ++repeated;
+            if (diagnostics::enabled(diagnostics::Level::SUMMARY)) {
+                diagnostics::Message() << "repeated local optimum; merge skipped (" << repeated << " repeats).";
+            }
+        } else if (parents.capacity() > 0) {
+            parents.add(new_tour);
+            if (diagnostics::enabled(diagnostics::Level::SUMMARY)) {
+                diagnostics::Message() << "pool: " << parents.size() << " tour(s), " << parents.common_edges() << " of "
+                    << parents.distinct_edges() << " distinct edges in all.";
+            }
+            kmove = merge::merge(current, parents, spatial_index, merge_budget);
+        } else {
+            kmove = merge::merge(current, new_tour, spatial_index, merge_budget);
+        }
         if (kmove) {
-            hill_climber.changed(*kmove);
-            hill_climb::hill_climb(hill_climber, tour, kmax);
+            climber.changed(*kmove);
+            hill_climb::hill_climb(climber, current, kmax);
+        }
+    };
+
+    const auto islands = config.get<size_t>("islands", 1);
+    std::cout << "islands: " << islands << std::endl;
+    if (islands > 1) {
+        const auto island_sync = std::max<size_t>(1, config.get<size_t>("island_sync", 8));
+        // tour is the global best, shared by the islands under best_mutex.
+        std::mutex best_mutex;
+        // each island starts from its own copy of tour, made before any island can replace it.
+        std::vector<Tour> starts(islands, tour);
+        const auto island = [&](size_t id) {
+            // the islands keep the cores busy; merges only get this island's share.
+            parallel::thread_limit = std::max<size_t>(1, parallel::thread_count() / islands);
+            Tour current = std::move(starts[id]);
+            // a copy of the climber of tour, which has searched every point already.
+            // it is pointed at current, as other islands replace tour.
+            auto climber = hill_climber;
+            climber.set_tour(current);
+            merge::Pool parents(pool.capacity());
+            SeenTours seen_before(seen_tours);
+            size_t repeated{0};
+            for (size_t round{1}; ; ++round) {
+                perturb_and_merge(climber, current, parents, seen_before, repeated);
+                if (round % island_sync != 0) {
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(best_mutex);
+                local_optima += island_sync;
+                if (current.length() < tour.length()) {
+                    tour = current;
+                    write_if_better(tour.length());
+                    if (diagnostics::enabled(diagnostics::Level::SUMMARY)) {
+                        diagnostics::Message() << "island " << id << ": best length: " << best_length
+                            << " (" << local_optima << " local optima)";
+                    }
+                    continue;
+                }
+                if (current.hash() == tour.hash()) {
+                    continue;
+                }
+                // merge the parts of this island's tour that improve the global best, then continue from it.
+                if (merge::merge(tour, current, spatial_index, merge_budget)) {
+                    write_if_better(tour.length());
+                    if (diagnostics::enabled(diagnostics::Level::SUMMARY)) {
+                        diagnostics::Message() << "island " << id << ": merged into best length: " << best_length
+                            << " (" << local_optima << " local optima)";
+                    }
+                }
+                auto best = tour;
+                lock.unlock();
+                // the climber only needs to search again around the edges that differ.
+                const auto [old_edges, new_edges] = merge::edge_differences(current, best);
+                std::vector<primitives::point_id_t> changed;
+                for (auto key : old_edges) {
+                    const auto edge = merge::unpack(key);
+                    changed.push_back(edge.first);
+                    changed.push_back(edge.second);
+                }
+                climber.changed(changed);
+                current = std::move(best);
+                hill_climb::hill_climb(climber, current, kmax);
+            }
+        };
+        std::vector<std::thread> threads;
+        for (size_t id{0}; id < islands; ++id) {
+            threads.emplace_back(island, id);
+        }
+        for (auto &thread : threads) {
+            thread.join();
         }
+        return EXIT_SUCCESS;
+    }
+
+    do {
+        perturb_and_merge(hill_climber, tour, pool, seen, repeats);
         write_if_better(tour.length());
         std::cout << "best length: " << best_length << std::endl;
         ++local_optima;
@@ -149,3 +240,88 @@ int main(int argc, const char** argv)
 
     return EXIT_SUCCESS;
 }
+
+// runs with a precomputed distance matrix if the instance is small enough.
+// Lookups only beat computing cheap lengths while the matrix fits in cache (about 700 points for 1 MB),
+// so by default only metrics with expensive lengths get large matrices.
+template <typename Metric>
+int run_with_lengths(const Config &config
+    , const Metric &metric
+    , const point_quadtree::Domain &domain
+    , const std::vector<primitives::point_id_t> &initial_tour
+    , const SpatialIndex &spatial_index
+    , const std::filesystem::path &tsp_file_path)
+{
+    const auto n = spatial_index.size();
+    const auto max_points = config.get<size_t>("distance_matrix_max_points", 20000);
+    const auto max_kb = config.get<size_t>("distance_matrix_max_kb", Metric::CHEAP_LENGTH ? 1024 : 1024 * 1024);
+    const auto bytes = metric::Matrix<Metric>::bytes(n);
+    if (n > max_points or bytes > max_kb * 1024) {
+        return run(config, metric, domain, initial_tour, spatial_index, tsp_file_path);
+    }
+    NanoTimer timer;
+    timer.start();
+    const metric::Matrix<Metric> matrix(metric, n);
+    std::cout << "Finished distance matrix (" << bytes / 1024 << " KB) in " << timer.stop() / 1e9 << " seconds.\n\n";
+    return run(config, matrix, domain, initial_tour, spatial_index, tsp_file_path);
+}
+
+}  // namespace
+
+int main(int argc, const char** argv)
+{
+    if (argc == 1) {
+        std::cout << "Arguments: config_file_path" << std::endl;
+    }
+    // Read config file.
+    const std::string config_path = (argc == 1) ? "config.txt" : argv[1];
+    std::cout << "Reading config file: " << config_path << std::endl;
+    Config config(config_path);
+
+    // Read input files.
+    const std::optional<std::string> tsp_file_path_string = config.get("tsp_file_path");
+    if (not tsp_file_path_string) {
+        std::cout << "tsp_file_path not specified.\n";
+        return EXIT_FAILURE;
+    }
+    const std::filesystem::path tsp_file_path(*tsp_file_path_string);
+    const auto instance = fileio::read_instance(*tsp_file_path_string);
+    const auto &x = instance.x;
+    const auto &y = instance.y;
+    const auto initial_tour = fileio::initial_tour(x.size(), config.get("tour_file_path"));
+
+    point_quadtree::Domain domain(x, y);
+    std::cout << "domain aspect ratio: " << domain.xdim(0) / domain.ydim(0) << std::endl;
+    std::cout << "bounding x, y dim: "
+        << domain.xdim(0) << ", " << domain.ydim(0)
+        << std::endl;
+
+    // Spatial index.
+    NanoTimer timer;
+    timer.start();
+
+    const auto spatial_index_type = config.get<std::string>("spatial_index", "quadtree");
+    const auto coincident_members = config.get<size_t>("coincident_members", 0);
+    const auto spatial_index = make_spatial_index(spatial_index_type, x, y, domain, instance.z, coincident_members);
+    std::cout << "Finished " << spatial_index_type << " in " << timer.stop() / 1e9 << " seconds.\n\n";
+
+    // the metric is fixed for the whole run, so everything downstream is compiled for it.
+    const auto &type = instance.edge_weight_type;
+    if (type == "EUC_2D") {
+        return run_with_lengths(config, metric::Euc2d(x, y), domain, initial_tour, *spatial_index, tsp_file_path);
+    }
+    if (type == "CEIL_2D") {
+        return run_with_lengths(config, metric::Ceil2d(x, y), domain, initial_tour, *spatial_index, tsp_file_path);
+    }
+    if (type == "ATT") {
+        return run_with_lengths(config, metric::Att(x, y), domain, initial_tour, *spatial_index, tsp_file_path);
+    }
+    if (type == "GEO") {
+        return run_with_lengths(config, metric::Geo(x, y), domain, initial_tour, *spatial_index, tsp_file_path);
+    }
+    if (type == "EUC_3D") {
+        return run_with_lengths(config, metric::Euc3d(x, y, instance.z), domain, initial_tour, *spatial_index, tsp_file_path);
+    }
+    std::cout << "unsupported EDGE_WEIGHT_TYPE: " << type << std::endl;
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,143 @@
+#include "length_calculator.hh"
+
+#if defined(__x86_64__) or defined(__i386__)
+#include <immintrin.h>
+#define LENGTH_CALCULATOR_X86
+#endif
+
+namespace {
+
+// Each kernel computes the lengths of a prefix of b, in blocks of its vector width,
+// and returns the prefix size. The rest is left to the scalar loop.
+// Kernels match the scalar operator() bit for bit: the same sequence of correctly rounded
+// IEEE operations, then the same truncation of exact + 0.5 to an integer.
+using Kernel = size_t (*)(const primitives::space_t* x
+    , const primitives::space_t* y
+    , primitives::point_id_t a
+    , const primitives::point_id_t* b
+    , size_t count
+    , primitives::length_t* out);
+
+size_t no_kernel(const primitives::space_t*
+    , const primitives::space_t*
+    , primitives::point_id_t
+    , const primitives::point_id_t*
+    , size_t
+    , primitives::length_t*)
+{
+    return 0;
+}
+
+#ifdef LENGTH_CALCULATOR_X86
+
+constexpr primitives::space_t MagicTwo52 {4503599627370496.0}; // 2^52.
+
+// the avx2 target does not enable FMA, so the multiplies and add cannot be contracted.
+__attribute__((target("avx2")))
+size_t avx2_kernel(const primitives::space_t* x
+    , const primitives::space_t* y
+    , primitives::point_id_t a
+    , const primitives::point_id_t* b
+    , size_t count
+    , primitives::length_t* out)
+{
+    const auto xa = _mm256_set1_pd(x[a]);
+    const auto ya = _mm256_set1_pd(y[a]);
+    const auto half = _mm256_set1_pd(0.5);
+    const auto magic = _mm256_set1_pd(MagicTwo52);
+    size_t k {0};
+    for (; k + 4 <= count; k += 4)
+    {
+        // scalar loads are faster than gathers on CPUs with the gather data sampling mitigation.
+        const auto xb = _mm256_set_pd(x[b[k + 3]], x[b[k + 2]], x[b[k + 1]], x[b[k]]);
+        const auto yb = _mm256_set_pd(y[b[k + 3]], y[b[k + 2]], y[b[k + 1]], y[b[k]]);
+        const auto dx = _mm256_sub_pd(xa, xb);
+        const auto dy = _mm256_sub_pd(ya, yb);
+        const auto exact = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)));
+        const auto truncated = _mm256_round_pd(_mm256_add_pd(exact, half), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+        if (_mm256_movemask_pd(_mm256_cmp_pd(truncated, magic, _CMP_LT_OQ)) != 0b1111)
+        {
+            break; // too long for the conversion below (or NaN); leave the rest to the scalar loop.
+        }
+        // for integers in [0, 2^52), the low mantissa bits of (integer + 2^52) are the integer.
+        const auto bits = _mm256_sub_epi64(_mm256_castpd_si256(_mm256_add_pd(truncated, magic)), _mm256_castpd_si256(magic));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + k), bits);
+    }
+    return k;
+}
+
+// AVX-512F includes 512-bit FMA, so explicit-rounding intrinsics are used to keep
+// the compiler from contracting the multiplies and add (which would change results).
+// The zero-masked forms avoid -Wmaybe-uninitialized from the unmasked ones.
+__attribute__((target("avx512f")))
+size_t avx512_kernel(const primitives::space_t* x
+    , const primitives::space_t* y
+    , primitives::point_id_t a
+    , const primitives::point_id_t* b
+    , size_t count
+    , primitives::length_t* out)
+{
+    constexpr int Rounding {_MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC};
+    constexpr __mmask8 AllLanes {0xFF};
+    const auto xa = _mm512_set1_pd(x[a]);
+    const auto ya = _mm512_set1_pd(y[a]);
+    const auto half = _mm512_set1_pd(0.5);
+    const auto magic = _mm512_set1_pd(MagicTwo52);
+    size_t k {0};
+    for (; k + 8 <= count; k += 8)
+    {
+        const auto xb = _mm512_set_pd(x[b[k + 7]], x[b[k + 6]], x[b[k + 5]], x[b[k + 4]]
+            , x[b[k + 3]], x[b[k + 2]], x[b[k + 1]], x[b[k]]);
+        const auto yb = _mm512_set_pd(y[b[k + 7]], y[b[k + 6]], y[b[k + 5]], y[b[k + 4]]
+            , y[b[k + 3]], y[b[k + 2]], y[b[k + 1]], y[b[k]]);
+        const auto dx = _mm512_maskz_sub_round_pd(AllLanes, xa, xb, Rounding);
+        const auto dy = _mm512_maskz_sub_round_pd(AllLanes, ya, yb, Rounding);
+        const auto squared = _mm512_maskz_add_round_pd(AllLanes
+            , _mm512_maskz_mul_round_pd(AllLanes, dx, dx, Rounding)
+            , _mm512_maskz_mul_round_pd(AllLanes, dy, dy, Rounding)
+            , Rounding);
+        const auto exact = _mm512_maskz_sqrt_round_pd(AllLanes, squared, Rounding);
+        const auto rounded = _mm512_maskz_add_round_pd(AllLanes, exact, half, Rounding);
+        const auto truncated = _mm512_maskz_roundscale_pd(AllLanes, rounded, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+        if (_mm512_cmp_pd_mask(truncated, magic, _CMP_LT_OQ) != AllLanes)
+        {
+            break; // too long for the conversion below (or NaN); leave the rest to the scalar loop.
+        }
+        const auto sum = _mm512_maskz_add_round_pd(AllLanes, truncated, magic, Rounding);
+        const auto bits = _mm512_sub_epi64(_mm512_castpd_si512(sum), _mm512_castpd_si512(magic));
+        _mm512_storeu_si512(out + k, bits);
+    }
+    return k;
+}
+
+#endif
+
+Kernel select_kernel()
+{
+#ifdef LENGTH_CALCULATOR_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return avx512_kernel;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return avx2_kernel;
+    }
+#endif
+    return no_kernel;
+}
+
+} // namespace
+
+void LengthCalculator::operator()(primitives::point_id_t a
+    , const primitives::point_id_t* b
+    , size_t count
+    , primitives::length_t* out) const
+{
+    static const Kernel kernel {select_kernel()};
+    for (auto k = kernel(m_x->data(), m_y->data(), a, b, count, out); k < count; ++k)
+    {
+        out[k] = operator()(a, b[k]);
+    }
+}
@@ -3,6 +3,7 @@
 #include "primitives.hh"
 
 #include <cmath>
+#include <cstddef> // size_t
 #include <vector>
 
 class LengthCalculator
@@ -14,6 +15,11 @@ public:
         : m_x(&x), m_y(&y) {}
 
     primitives::length_t operator()(primitives::point_id_t a, primitives::point_id_t b) const;
+    // out[k] = operator()(a, b[k]) for k in [0, count), vectorized when the CPU supports it.
+    void operator()(primitives::point_id_t a
+        , const primitives::point_id_t* b
+        , size_t count
+        , primitives::length_t* out) const;
 
     const auto& x() const { return *m_x; }
     const auto& y() const { return *m_y; }
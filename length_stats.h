@@ -1,6 +1,5 @@
 #pragma once
 
-#include "length_calculator.hh"
 #include "tour.hh"
 #include "primitives.hh"
 
@@ -11,12 +10,10 @@ namespace length_stats {
 
 void print_lengths(const Tour& tour)
 {
-    const LengthCalculator length_calculator(tour.x(), tour.y());
     std::map<primitives::length_t, size_t> lengths;
     for (primitives::point_id_t i {0}; i < tour.size(); ++i)
     {
-        auto length = length_calculator(i, tour.next(i));
-        ++lengths[length];
+        ++lengths[tour.length(i)];
     }
     for (const auto& pair : lengths)
     {
@@ -0,0 +1,407 @@
+#include "combinator.hh"
+
+#include "cycle_util.hh"
+#include <diagnostics.hh>
+
+#include <algorithm> // binary_search, find_if, lexicographical_compare, max, min, sort
+#include <cstddef> // ptrdiff_t
+#include <limits>
+#include <stdexcept> // logic_error
+#include <unordered_map>
+#include <utility> // pair
+
+namespace merge {
+
+namespace {
+
+constexpr uint32_t NO_ENDPOINT{std::numeric_limits<uint32_t>::max()};
+
+// splitmix64 of the pair.
+uint64_t pair_hash(uint64_t a, uint64_t b) {
+    auto z = (a << 32 | b) + 0x9e3779b97f4a7c15;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+}  // namespace
+
+Combinator::Combinator(const std::vector<ExchangePair> &sorted_exchange_pairs
+    , const Tour &best_tour
+    , CombinatorBudget budget
+    , size_t threads)
+    : exchanges_(sorted_exchange_pairs.size())
+    , budget_(budget)
+    , threads_(std::max<size_t>(1, threads))
+    , remaining_gain_(exchanges_ + 1, 0) {
+    for (size_t e{0}; e < exchanges_; ++e) {
+        const auto &exchange_pair = sorted_exchange_pairs[e];
+        improvements_.push_back(*exchange_pair.improvement);
+        for (const auto &pair : exchange_pair.current.map()) {
+            for (const auto *edge : {&pair.second.first, &pair.second.second}) {
+                // each edge is stored for both of its points.
+                if (*edge and (*edge)->first == pair.first) {
+                    const auto normalized = cycle_util::normalize_edge(best_tour, **edge);
+                    cuts_.push_back({best_tour.sequence(normalized.first, 0), normalized.first, e});
+                }
+            }
+        }
+    }
+    for (size_t e{exchanges_}; e > 0; --e) {
+        remaining_gain_[e - 1] = remaining_gain_[e] + std::max(improvements_[e - 1], 0);
+    }
+    std::sort(std::begin(cuts_), std::end(cuts_), [](const Cut &lhs, const Cut &rhs) {
+        return lhs.sequence < rhs.sequence;
+    });
+
+    // attach each added edge to a free endpoint of each of its points.
+    std::unordered_map<primitives::point_id_t, std::vector<Endpoint>> free_endpoints;
+    for (Endpoint c{0}; c < cuts_.size(); ++c) {
+        free_endpoints[cuts_[c].point].push_back(2 * c);
+        free_endpoints[best_tour.next(cuts_[c].point)].push_back(2 * c + 1);
+    }
+    const auto take = [&free_endpoints](primitives::point_id_t point) {
+        auto &endpoints = free_endpoints[point];
+        if (endpoints.empty()) {
+            throw std::logic_error("added edge at a point without a removed edge.");
+        }
+        const auto endpoint = endpoints.back();
+        endpoints.pop_back();
+        return endpoint;
+    };
+    add_partner_.resize(2 * cuts_.size());
+    for (const auto &exchange_pair : sorted_exchange_pairs) {
+        for (const auto &pair : exchange_pair.candidate.map()) {
+            for (const auto *edge : {&pair.second.first, &pair.second.second}) {
+                if (*edge and (*edge)->first == pair.first) {
+                    const auto a = take((*edge)->first);
+                    const auto b = take((*edge)->second);
+                    add_partner_[a] = b;
+                    add_partner_[b] = a;
+                }
+            }
+        }
+    }
+    for (const auto &pair : free_endpoints) {
+        if (not pair.second.empty()) {
+            throw std::logic_error("removed edge at a point without an added edge.");
+        }
+    }
+
+    exchange_cuts_.resize(exchanges_);
+    for (size_t c{0}; c < cuts_.size(); ++c) {
+        exchange_cuts_[cuts_[c].exchange].push_back(c);
+    }
+    initial_partner_.resize(2 * cuts_.size());
+    for (size_t c{0}; c < cuts_.size(); ++c) {
+        const Endpoint after = 2 * c + 1;
+        const Endpoint before = 2 * ((c + 1) % cuts_.size());
+        initial_partner_[after] = before;
+        initial_partner_[before] = after;
+    }
+    for (Endpoint endpoint{0}; endpoint < initial_partner_.size(); ++endpoint) {
+        initial_hash_ ^= pair_hash(endpoint, initial_partner_[endpoint]);
+    }
+}
+
+// Search state of one thread.
+class Combinator::Worker {
+ public:
+    explicit Worker(Combinator &combinator)
+        : c_(combinator)
+        , partner_(combinator.initial_partner_)
+        , hash_(combinator.initial_hash_)
+        , visited_(partner_.size(), 0) {}
+
+    // searches from the root; with split, subtrees below the split depth are left as tasks.
+    void search(bool split) {
+        split_ = split;
+        visit(0, false, 0);
+        flush_nodes();
+    }
+
+    // searches the subtree below a task's decided combo.
+    void search(const Combo &task) {
+        split_ = false;
+        size_t closed{0};
+        for (size_t i{0}; i < c_.split_depth_; ++i) {
+            const bool include = std::binary_search(std::cbegin(task), std::cend(task), i);
+            closed += decide(i, include);
+            if (include) {
+                combo_.push_back(i);
+                margin_ += c_.improvements_[i];
+            }
+        }
+        if (closed == 0) {
+            expand(c_.split_depth_);
+        }
+        undo(0);
+        hash_ = c_.initial_hash_;
+        combo_.clear();
+        margin_ = 0;
+        flush_nodes();
+    }
+
+ private:
+    Combinator &c_;
+    bool split_{false};
+
+    Combo combo_;
+    int margin_{0};
+
+    // best margin seen for each node state.
+    std::unordered_map<uint64_t, int> memo_;
+
+    // for each port endpoint, the port endpoint it is connected to through the decided exchanges.
+    std::vector<Endpoint> partner_;
+    // XOR of the hashes of the (port endpoint, partner) pairs.
+    uint64_t hash_{0};
+    // (endpoint, previous partner), to undo decisions.
+    std::vector<std::pair<Endpoint, Endpoint>> undo_;
+    std::vector<uint32_t> visited_;
+    uint32_t epoch_{0};
+
+    // nodes not yet added to the shared count.
+    size_t nodes_{0};
+
+    // exchanges [0, i) are decided; closed is the number of cycles without ports.
+    void visit(size_t i, bool included, size_t closed) {
+        if (out_of_budget()) {
+            return;
+        }
+        ++nodes_;
+        if (included and margin_ >= c_.best_.load(std::memory_order_relaxed)) {
+            const auto count = cycles(i, closed);
+            if (count == 1) {
+                c_.record(combo_, margin_);
+            } else if (count == 2) {
+                c_.record_two_cycles(combo_, margin_);
+            }
+        }
+        if (i == c_.exchanges_ or closed > 0) {
+            return;
+        }
+        if (split_ and i == c_.split_depth_) {
+            c_.tasks_.push_back(combo_);
+            return;
+        }
+        expand(i);
+    }
+
+    // branches on exchange i.
+    void expand(size_t i) {
+        const auto bound = margin_ + c_.remaining_gain_[i];
+        if (bound <= c_.best_.load(std::memory_order_relaxed) and dominated(i, bound)) {
+            return;
+        }
+        const auto [it, inserted] = memo_.emplace(hash_ ^ pair_hash(NO_ENDPOINT, i), margin_);
+        if (not inserted) {
+            if (it->second >= margin_) {
+                return;
+            }
+            it->second = margin_;
+        }
+        const auto hash = hash_;
+        const auto undo_size = undo_.size();
+        const auto improvement = c_.improvements_[i];
+        if (margin_ + improvement > 0) {
+            const auto closed = decide(i, true);
+            combo_.push_back(i);
+            margin_ += improvement;
+            visit(i + 1, true, closed);
+            margin_ -= improvement;
+            combo_.pop_back();
+            undo(undo_size);
+            hash_ = hash;
+        }
+        const auto closed = decide(i, false);
+        visit(i + 1, false, closed);
+        undo(undo_size);
+        hash_ = hash;
+    }
+
+    // true if no combo below the node can beat the best so far, given its bound on the improvement.
+    bool dominated(size_t i, int bound) {
+        std::lock_guard<std::mutex> lock(c_.best_mutex_);
+        if (not c_.best_improvement_ or bound > *c_.best_improvement_) {
+            return false;
+        }
+        if (bound < *c_.best_improvement_) {
+            return true;
+        }
+        // on a tie, the combos below (combo_ plus exchanges from [i, end)) must all come after the best.
+        const auto &best = *c_.best_combo_;
+        for (size_t k{0}; k < combo_.size(); ++k) {
+            if (k == best.size() or combo_[k] > best[k]) {
+                return true;
+            }
+            if (combo_[k] < best[k]) {
+                return false;
+            }
+        }
+        return combo_.size() == best.size() or best[combo_.size()] < i;
+    }
+
+    // decides exchange i and returns the number of cycles that this closes.
+    size_t decide(size_t i, bool include) {
+        // an exchange joins its endpoints by its added edges, or else by the tour edges it would remove.
+        const auto link = [this, include](Endpoint endpoint) {
+            return include ? c_.add_partner_[endpoint] : endpoint ^ 1;
+        };
+        const auto undecided = [this, i](Endpoint endpoint) { return c_.cuts_[endpoint / 2].exchange > i; };
+        // follows partners and links from endpoint to a port of an undecided exchange, or back to start.
+        const auto walk = [this, &link, &undecided](Endpoint start, Endpoint endpoint) -> std::optional<Endpoint> {
+            while (true) {
+                visited_[endpoint] = epoch_;
+                const auto partner = partner_[endpoint];
+                if (undecided(partner)) {
+                    return partner;
+                }
+                visited_[partner] = epoch_;
+                endpoint = link(partner);
+                if (endpoint == start) {
+                    return std::nullopt;
+                }
+            }
+        };
+        size_t closed{0};
+        ++epoch_;
+        for (auto c : c_.exchange_cuts_[i]) {
+            for (Endpoint endpoint : {2 * c, 2 * c + 1}) {
+                hash_ ^= pair_hash(endpoint, partner_[endpoint]);
+                if (visited_[endpoint] == epoch_) {
+                    continue;
+                }
+                const auto end = walk(endpoint, endpoint);
+                if (not end) {
+                    ++closed;
+                    continue;
+                }
+                const auto other_end = *walk(endpoint, link(endpoint));
+                set_partner(*end, other_end);
+                set_partner(other_end, *end);
+            }
+        }
+        return closed;
+    }
+
+    void set_partner(Endpoint endpoint, Endpoint partner) {
+        undo_.emplace_back(endpoint, partner_[endpoint]);
+        hash_ ^= pair_hash(endpoint, partner_[endpoint]) ^ pair_hash(endpoint, partner);
+        partner_[endpoint] = partner;
+    }
+
+    void undo(size_t undo_size) {
+        while (undo_.size() > undo_size) {
+            partner_[undo_.back().first] = undo_.back().second;
+            undo_.pop_back();
+        }
+    }
+
+    // cycles of the chosen subset on its own, with exchanges [0, i) decided.
+    size_t cycles(size_t i, size_t closed) {
+        // without the undecided exchanges, each port is joined to the other side of its cut by the tour edge.
+        auto cycles = closed;
+        ++epoch_;
+        for (auto e{i}; e < c_.exchanges_; ++e) {
+            for (auto c : c_.exchange_cuts_[e]) {
+                const Endpoint start = 2 * c;
+                if (visited_[start] == epoch_) {
+                    continue;
+                }
+                ++cycles;
+                auto endpoint = start;
+                do {
+                    visited_[endpoint] = epoch_;
+                    const auto partner = partner_[endpoint];
+                    visited_[partner] = epoch_;
+                    endpoint = partner ^ 1;
+                } while (endpoint != start);
+            }
+        }
+        return cycles;
+    }
+
+    void flush_nodes() {
+        c_.nodes_ += nodes_;
+        nodes_ = 0;
+    }
+
+    bool out_of_budget() {
+        constexpr size_t FLUSH_INTERVAL{64};
+        constexpr size_t TIME_CHECK_INTERVAL{1024};
+        if (nodes_ >= FLUSH_INTERVAL) {
+            const auto nodes = c_.nodes_.fetch_add(nodes_) + nodes_;
+            nodes_ = 0;
+            if (nodes >= c_.budget_.max_nodes
+                or (nodes % TIME_CHECK_INTERVAL < FLUSH_INTERVAL and c_.timer_.stop() / 1e9 > c_.budget_.max_seconds)) {
+                c_.exhausted_ = true;
+            }
+        }
+        return c_.exhausted_.load(std::memory_order_relaxed);
+    }
+};
+
+void Combinator::find() {
+    timer_.start();
+    Worker main(*this);
+    // small groups search a few hundred nodes, in less time than starting threads takes.
+    constexpr size_t MIN_PARALLEL_EXCHANGES{20};
+    if (threads_ == 1 or exchanges_ < MIN_PARALLEL_EXCHANGES) {
+        main.search(false);
+        return;
+    }
+    // enough tasks that threads finishing early find more work.
+    constexpr size_t TASKS_PER_THREAD{16};
+    while (split_depth_ < exchanges_ and (size_t{1} << split_depth_) < TASKS_PER_THREAD * threads_) {
+        ++split_depth_;
+    }
+    main.search(true);
+    // pruning above the split depth can leave fewer tasks than threads.
+    const auto workers = std::min(threads_, tasks_.size());
+    parallel::blocks(workers, [this](size_t, size_t, size_t) {
+        Worker worker(*this);
+        for (auto t = next_task_++; t < tasks_.size(); t = next_task_++) {
+            worker.search(tasks_[t]);
+        }
+    }, workers);
+}
+
+void Combinator::record_two_cycles(const Combo &combo, int margin) {
+    std::lock_guard<std::mutex> lock(best_mutex_);
+    const std::pair<int, Combo> entry{margin, combo};
+    // best first: higher improvement, then the lexicographically smaller combo.
+    const auto position = std::find_if(std::cbegin(two_cycle_combos_), std::cend(two_cycle_combos_), [&entry](const auto &other) {
+        return other.first < entry.first
+            or (other.first == entry.first and entry.second < other.second);
+    });
+    if (position - std::cbegin(two_cycle_combos_) >= static_cast<std::ptrdiff_t>(MAX_TWO_CYCLE_COMBOS)) {
+        return;
+    }
+    two_cycle_combos_.insert(position, entry);
+    if (two_cycle_combos_.size() > MAX_TWO_CYCLE_COMBOS) {
+        two_cycle_combos_.pop_back();
+    }
+}
+
+void Combinator::record(const Combo &combo, int margin) {
+    std::lock_guard<std::mutex> lock(best_mutex_);
+    if (best_improvement_ and (margin < *best_improvement_
+        or (margin == *best_improvement_ and not std::lexicographical_compare(
+            std::cbegin(combo), std::cend(combo), std::cbegin(*best_combo_), std::cend(*best_combo_))))) {
+        return;
+    }
+    ++viable_count_;
+    best_combo_ = combo;
+    best_improvement_ = margin;
+    best_ = margin;
+    if (diagnostics::enabled(diagnostics::Level::DETAIL)) {
+        diagnostics::Message message;
+        message << "better combo:";
+        for (const auto &i : combo) {
+            message << ' ' << i;
+        }
+    }
+}
+
+}  // namespace merge
@@ -1,98 +1,113 @@
 #pragma once
 
-#include <vector>
-#include <optional>
-#include <fstream>
+// Branch-and-bound search over subsets of exchange pairs for the best subset that,
+// applied to the best tour, leaves a single cycle.
+//
+// The removed edges of all exchange pairs are cut points of the best tour, put in tour order once.
+// Exchanges are decided in order. A search node keeps the cuts of the undecided exchanges ("ports") open
+// and records how the decided ones connect the ports to each other, which is all that the undecided exchanges
+// can see of them. Deciding an exchange only re-links the ports that led into it, so:
+// - a cycle that no longer touches a port is found as it closes; no completion can then be feasible.
+// - nodes at the same depth with the same connections are equivalent (compared by hash);
+//   only the best margin is searched further.
+// - whether the chosen subset on its own is a single cycle is only checked when it would be the best so far.
+// Above a split depth the tree is enumerated serially; the subtrees below it are tasks for worker threads,
+// which take the next task as they finish and prune against the best improvement of all workers.
+// Groups of fewer than 20 exchanges are searched serially, and no more workers are started than there are tasks.
 
-#include "cycle_util.hh"
 #include "exchange_pair.hh"
-#include <debug_util.hh>
-#include <multicycle_tour.hh>
+#include <NanoTimer.h>
+#include <parallel.hh>
+#include <primitives.hh>
+#include <tour.hh>
+
+#include <atomic>
+#include <cstdint> // uint32_t, uint64_t
+#include <mutex>
+#include <optional>
+#include <utility> // pair
+#include <vector>
 
 namespace merge {
 
+struct CombinatorBudget {
+    size_t max_nodes{1000000};
+    double max_seconds{1};
+};
+
 class Combinator {
  public:
     // Exchange pairs are sorted by improvement, highest to lowest.
-    Combinator(const std::vector<ExchangePair> &sorted_exchange_pairs, const Tour &best_tour, const Tour &candidate_tour)
-        : exchange_pairs_(sorted_exchange_pairs), best_tour_(best_tour), candidate_tour_(candidate_tour) {}
-
-    void find(size_t i = 0) {
-        if (i == exchange_pairs_.size()) {
-            return;
-        }
-        const auto improvement = *exchange_pairs_[i].improvement;
-        if (margin_ + improvement <= 0) {
-            return;
-        }
-        combo_.push_back(i);
-        margin_ += improvement;
-        check_combo();
-        find(i + 1); // try with this.
-        combo_.pop_back();
-        margin_ -= improvement;
-        find(i + 1); // try without this.
-    }
+    Combinator(const std::vector<ExchangePair> &sorted_exchange_pairs
+        , const Tour &best_tour
+        , CombinatorBudget budget = {}
+        , size_t threads = parallel::thread_count());
+
+    // Among combos of equal improvement, finds the first in include-first search order
+    // (the lexicographically smallest), so the result does not depend on the thread count
+    // unless the budget runs out.
+    void find();
 
+    // viable combos found, each better than the ones before.
     size_t viable_count() const { return viable_count_; }
     const auto &best_combo() const { return best_combo_; }
     const auto &best_improvement() const { return best_improvement_; }
-    const auto &checks() const { return checks_; }
+    // (improvement, combo) of the best combos found that leave exactly two cycles
+    // and improve more than any viable combo found before them; best first. Their cycles may be joined by a patch.
+    const auto &two_cycle_combos() const { return two_cycle_combos_; }
+    // search nodes evaluated.
+    size_t checks() const { return nodes_; }
+    // true if the budget ran out before the search finished.
+    bool exhausted() const { return exhausted_; }
 
  private:
-    const std::vector<ExchangePair> &exchange_pairs_;
-    const Tour &best_tour_;
-    const Tour &candidate_tour_;
-
+    class Worker;
     using Combo = std::vector<size_t>;
-    Combo combo_;
+    // cut c has endpoints 2c (the point before the cut, in tour order) and 2c + 1 (the point after).
+    using Endpoint = uint32_t;
+
+    struct Cut {
+        primitives::sequence_t sequence;
+        primitives::point_id_t point; // before the cut.
+        size_t exchange;
+    };
+
+    const size_t exchanges_;
+    const CombinatorBudget budget_;
+    const size_t threads_;
+
+    std::vector<int> improvements_;
+    // sum of the positive improvements of exchanges [i, end).
+    std::vector<int> remaining_gain_;
+    std::vector<Cut> cuts_;
+    std::vector<std::vector<size_t>> exchange_cuts_;
+    std::vector<Endpoint> add_partner_;
+    // port connections with nothing decided: the segment after each cut ends at the next cut.
+    std::vector<Endpoint> initial_partner_;
+    uint64_t initial_hash_{0};
+
+    // the subtrees below split_depth_ are searched by the worker threads, as tasks given by their decided combos.
+    size_t split_depth_{0};
+    std::vector<Combo> tasks_;
+    std::atomic<size_t> next_task_{0};
+
+    // best combo so far, shared by the workers. best_ mirrors best_improvement_ for lock-free pruning;
+    // it is 0 until a combo is found, as viable combos improve by at least 1.
+    std::mutex best_mutex_;
+    std::atomic<int> best_{0};
     std::optional<int> best_improvement_;
     std::optional<Combo> best_combo_;
-    int margin_{0};
     size_t viable_count_{0};
-    size_t checks_{0};
-
-    void check_combo() {
-        ++checks_;
-        const auto breaks_cycle = cycle_util::breaks_cycle(best_tour_, candidate_tour_, exchange_pairs_, combo_);
-        if (breaks_cycle) {
-            if (cycle_util::count_cycles(best_tour_, candidate_tour_, exchange_pairs_, combo_) == 2) {
-                std::cout << "found double cycle tour with margin " << margin_ << std::endl;
-                // perform swap, output cycles for plotting.
-                const auto &kmove = cycle_util::to_kmove(best_tour_, candidate_tour_, exchange_pairs_, combo_);
-                MulticycleTour test_tour = best_tour_;
-                test_tour.multicycle_swap(kmove);
-                const auto &cycles = cycle_util::compute_cycles(test_tour.next());
-                if (cycles.size() != 2) {
-                    throw std::logic_error("unexpected cycle count.");
-                }
-                if (0.05 < std::min(cycles[0].size(), cycles[1].size()) / static_cast<double>(test_tour.size())) {
-                    std::cout << "writing out cycles for plotting.\n";
-                    primitives::cycle_id_t cycle_id{0};
-                    for (const auto &cycle : cycles) {
-                        std::ofstream cycle_file("output/cycle" + std::to_string(cycle_id) + "_margin_" + std::to_string(margin_) + ".txt", std::ofstream::out);
-                        primitives::point_id_t prev{cycle.back()};
-                        for (const auto &i : cycle) {
-                            cycle_file << prev << ' ' << i << std::endl;
-                            prev = i;
-                        }
-                        ++cycle_id;
-                    }
-                }
-            }
-            return;
-        }
-        ++viable_count_;
-        if (not best_improvement_ or margin_ > *best_improvement_) {
-            best_combo_ = std::make_optional<Combo>(combo_);
-            best_improvement_ = std::make_optional(margin_);
-            std::cout << "better combo: ";
-            for (const auto &i : *best_combo_) {
-                std::cout << i << " ";
-            }
-            std::cout << std::endl;
-        }
-    }
+    static constexpr size_t MAX_TWO_CYCLE_COMBOS{4};
+    std::vector<std::pair<int, Combo>> two_cycle_combos_;
+
+    std::atomic<size_t> nodes_{0};
+    std::atomic<bool> exhausted_{false};
+    NanoTimer timer_;
+
+    // keeps combo if it beats the best so far.
+    void record(const Combo &combo, int margin);
+    void record_two_cycles(const Combo &combo, int margin);
 };
 
 }  // namespace merge
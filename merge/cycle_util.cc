@@ -19,22 +19,32 @@ Edge normalize_edge(const Tour &tour, const Edge& mm_edge) {
 }
 
 // Takes edges in (min, max) form and converts them to (i, next(i)) form.
-std::set<Edge> normalize_edges(const Tour& tour, const EdgeMap &edge_map) {
-    std::set<Edge> normalized;
+std::vector<Edge> normalize_edges(const Tour& tour, const EdgeMap &edge_map) {
+    std::vector<Edge> normalized;
+    for (const auto &edge : edges(edge_map)) {
+        normalized.push_back(normalize_edge(tour, edge));
+    }
+    return normalized;
+}
+
+std::vector<Edge> edges(const EdgeMap &edge_map) {
+    std::vector<Edge> unique;
+    unique.reserve(edge_map.edge_count());
     for (const auto &pair : edge_map.map()) {
-        if (pair.second.first) {
-            normalized.insert(normalize_edge(tour, *pair.second.first));
-        }
-        if (pair.second.second) {
-            normalized.insert(normalize_edge(tour, *pair.second.second));
+        for (const auto *edge : {&pair.second.first, &pair.second.second}) {
+            // each edge is stored for both of its points.
+            if (*edge and (*edge)->first == pair.first) {
+                unique.push_back(**edge);
+            }
         }
     }
-    return normalized;
+    return unique;
 }
 
-void to_kmove(const Tour &best_tour, const Tour &candidate_tour, const ExchangePair &exchange_pair, KMove &kmove) {
+// added edges need no orientation, so they are taken as stored.
+void to_kmove(const Tour &best_tour, const ExchangePair &exchange_pair, KMove &kmove) {
     const auto &remove_set = normalize_edges(best_tour, exchange_pair.current);
-    const auto &add_set = normalize_edges(candidate_tour, exchange_pair.candidate);
+    const auto &add_set = edges(exchange_pair.candidate);
     for (const auto &edge : remove_set) {
         kmove.removes.push_back(edge.first);
     }
@@ -44,28 +54,32 @@ void to_kmove(const Tour &best_tour, const Tour &candidate_tour, const ExchangeP
     }
 }
 
-KMove to_kmove(const Tour &best_tour, const Tour &candidate_tour, const std::vector<ExchangePair> &exchange_pairs, const std::vector<size_t> &indices) {
+KMove to_kmove(const Tour &best_tour, const std::vector<ExchangePair> &exchange_pairs, const std::vector<size_t> &indices) {
     KMove kmove;
     for (const auto &i : indices) {
         const auto &e = exchange_pairs[i];
-        to_kmove(best_tour, candidate_tour, e, kmove);
+        to_kmove(best_tour, e, kmove);
     }
     return kmove;
 }
 
-bool breaks_cycle(const Tour &best_tour, const Tour &candidate_tour, const std::vector<ExchangePair> &exchange_pairs, const std::vector<size_t> &indices) {
-    const auto kmove = to_kmove(best_tour, candidate_tour, exchange_pairs, indices);
-    return cycle_check::breaks_cycle(best_tour, kmove);
+bool breaks_cycle(const Tour &best_tour, const std::vector<ExchangePair> &exchange_pairs, const std::vector<size_t> &indices) {
+    const auto kmove = to_kmove(best_tour, exchange_pairs, indices);
+    return not cycle_check::feasible(best_tour, kmove);
 }
 
-bool breaks_cycle(const Tour &best_tour, const Tour &candidate_tour, const ExchangePair &exchange_pair) {
+bool breaks_cycle(const Tour &best_tour, const ExchangePair &exchange_pair) {
     KMove kmove;
-    to_kmove(best_tour, candidate_tour, exchange_pair, kmove);
-    return cycle_check::breaks_cycle(best_tour, kmove);
+    to_kmove(best_tour, exchange_pair, kmove);
+    return not cycle_check::feasible(best_tour, kmove);
 }
 
-size_t count_cycles(const Tour &best_tour, const Tour &candidate_tour, const std::vector<ExchangePair> &exchange_pairs, const std::vector<size_t> &indices) {
-    const auto kmove = to_kmove(best_tour, candidate_tour, exchange_pairs, indices);
+size_t count_cycles(const Tour &best_tour, const std::vector<ExchangePair> &exchange_pairs, const std::vector<size_t> &indices) {
+    const auto kmove = to_kmove(best_tour, exchange_pairs, indices);
+    // the allocation-free check settles the common single-cycle case.
+    if (cycle_check::feasible(best_tour, kmove)) {
+        return 1;
+    }
     return cycle_check::count_cycles(best_tour, kmove);
 }
 
@@ -3,7 +3,9 @@
 #include <primitives.hh>
 
 #include <algorithm>
+#include <cstdint> // uint64_t
 #include <utility>
+#include <vector>
 
 namespace merge {
 
@@ -18,5 +20,17 @@ inline Edge make_edge(primitives::point_id_t i, primitives::point_id_t j) {
     return {std::min(i, j), std::max(i, j)};
 }
 
+// An edge packed into one integer, (min << 32) | max, for flat storage without per-edge allocations.
+using EdgeKey = std::uint64_t;
+using EdgeKeys = std::vector<EdgeKey>;
+
+inline EdgeKey pack(primitives::point_id_t i, primitives::point_id_t j) {
+    return (static_cast<EdgeKey>(std::min(i, j)) << 32) | std::max(i, j);
+}
+
+inline Edge unpack(EdgeKey key) {
+    return {static_cast<primitives::point_id_t>(key >> 32), static_cast<primitives::point_id_t>(key)};
+}
+
 }  // namespace merge
 
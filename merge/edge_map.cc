@@ -1,119 +1,81 @@
 #include "edge_map.hh"
 
-#include <iostream>
+#include <stdexcept>
 
 namespace merge {
 
-EdgeMap::EdgeMap(const EdgeSet &edge_set) {
-    for (const auto &edge : edge_set) {
-        insert(edge);
-    }
-}
+namespace {
 
-auto EdgeMap::insert(const Edge &edge) -> std::optional<Points> {
-    Points new_points;
-    if (insert(edge.first, edge)) {
-        new_points.push_back(edge.first);
-    }
-    if (insert(edge.second, edge)) {
-        new_points.push_back(edge.second);
-    }
-    return new_points.empty() ? std::nullopt : make_optional(new_points);
+// Fibonacci hashing: consecutive point ids spread over the whole table.
+size_t home_slot(primitives::point_id_t i, size_t slots) {
+    return static_cast<size_t>((static_cast<uint64_t>(i) * 0x9E3779B97F4A7C15ULL) >> 32) & (slots - 1);
 }
 
-auto EdgeMap::insert(const Edges &edges) -> std::optional<Points> {
-    Points new_points;
-    for (const auto &edge : edges) {
-        const auto &points = insert(edge);
-        if (points) {
-            new_points.insert(std::cend(new_points), std::cbegin(*points), std::cend(*points));
-        }
-    }
-    return new_points.empty() ? std::nullopt : make_optional(new_points);
+}  // namespace
+
+void EdgeMap::insert(const Edge &edge) {
+    insert(edge.first, edge);
+    insert(edge.second, edge);
 }
 
-bool EdgeMap::insert(primitives::point_id_t i, const Edge &edge) {
-    if (map_.find(i) == std::cend(map_)) {
-        map_[i].first = edge;
+void EdgeMap::insert(primitives::point_id_t i, const Edge &edge) {
+    size_t slot{0};
+    const auto e = find(i, slot);
+    if (e == entries_.size()) {
+        entries_.push_back({i, {edge, std::nullopt}});
         ++edge_count_;
-        return true;
+        if (not slots_.empty()) {
+            slots_[slot] = static_cast<uint32_t>(entries_.size());
+        }
+        if (2 * entries_.size() > slots_.size() and entries_.size() > MAX_LINEAR) {
+            rehash(slots_.empty() ? 4 * MAX_LINEAR : 2 * slots_.size());
+        }
+        return;
     }
+    auto &edges = entries_[e].second;
     // accept insertion of duplicates.
-    if (*map_[i].first == edge or *map_[i].second == edge) {
-        return false;
+    if (edges.first == edge or edges.second == edge) {
+        return;
     }
-    if (not map_[i].first) {
+    if (not edges.first) {
         throw std::logic_error("empty entry.");
     }
-    if (map_[i].second) {
+    if (edges.second) {
         throw std::logic_error("attempted to overfill an entry.");
     }
-    map_[i].second = edge;
+    edges.second = edge;
     ++edge_count_;
-    return false;
-}
-
-auto EdgeMap::pop_edge() -> Edge {
-    const auto it = std::begin(map_);
-    auto edge = *it->second.first;
-    remove_edges(edge);
-    return edge;
-}
-
-void EdgeMap::remove_edges(const Edge &edge) {
-    --edge_count_;
-    remove_edge(edge.first, edge);
-    remove_edge(edge.second, edge);
 }
 
-void EdgeMap::remove_edge(primitives::point_id_t i, const Edge &edge) {
-    auto it = map_.find(i);
-    if (it == std::cend(map_)) {
-        return;
-    }
-    if (*map_[i].first == edge) {
-        std::swap(map_[i].first, map_[i].second);
-        map_[i].second = std::nullopt;
-        if (not map_[i].first) {
-            map_.erase(it);
+size_t EdgeMap::find(primitives::point_id_t i, size_t &slot) const {
+    if (slots_.empty()) {
+        for (size_t e{0}; e < entries_.size(); ++e) {
+            if (entries_[e].first == i) {
+                return e;
+            }
         }
+        return entries_.size();
     }
-    if (*map_[i].second == edge) {
-        map_[i].second = std::nullopt;
-    }
-}
-
-auto EdgeMap::pop_edges(const Point &i) -> std::optional<Edges> {
-    auto it = map_.find(i);
-    if (it == std::cend(map_)) {
-        return std::nullopt;
-    }
-    auto edge_pair = it->second;
-    map_.erase(it);
-    EdgeMap::Edges edges;
-    if (edge_pair.first) {
-        --edge_count_;
-        edges.push_back(*edge_pair.first);
-    }
-    if (edge_pair.second) {
-        --edge_count_;
-        edges.push_back(*edge_pair.second);
+    slot = home_slot(i, slots_.size());
+    while (slots_[slot] != EMPTY_SLOT) {
+        const auto e = slots_[slot] - 1;
+        if (entries_[e].first == i) {
+            return e;
+        }
+        slot = (slot + 1) & (slots_.size() - 1);
     }
-    return edges;
+    return entries_.size();
 }
 
-auto EdgeMap::pop_edges(const Points &points) -> std::optional<Edges> {
-    Edges edges;
-    for (const auto &i : points) {
-        const auto popped = pop_edges(i);
-        if (popped) {
-            edges.insert(std::cend(edges), std::cbegin(*popped), std::cend(*popped));
+void EdgeMap::rehash(size_t slots) {
+    slots_.assign(slots, EMPTY_SLOT);
+    for (size_t e{0}; e < entries_.size(); ++e) {
+        auto slot = home_slot(entries_[e].first, slots);
+        while (slots_[slot] != EMPTY_SLOT) {
+            slot = (slot + 1) & (slots - 1);
         }
+        slots_[slot] = static_cast<uint32_t>(e + 1);
     }
-    if (edges.empty()) {
-        return std::nullopt;
-    }
-    return edges;
 }
 
 }  // namespace merge
@@ -1,13 +1,16 @@
 #pragma once
 
 // Maps points to their edges.
+// Entries are kept densely, in insertion order, so iterating a map is a scan of one vector.
+// Small maps (as most exchange pairs are) are searched linearly; larger ones through an open-addressed table
+// of entry indices (linear probing, at most half full). Nothing is allocated per entry.
 
 #include "edge.hh"
-#include "edge_set.hh"
 
 #include <primitives.hh>
 
-#include <unordered_map>
+#include <cstdint> // uint32_t
+#include <utility>
 #include <vector>
 #include <optional>
 
@@ -15,35 +18,34 @@ namespace merge {
 
 struct EdgeMap {
     using Point = primitives::point_id_t;
-    using Points = std::vector<Point>;
-    using Edges = std::vector<Edge>;
     using IncidentEdges = std::pair<std::optional<Edge>, std::optional<Edge>>;
+    using Entry = std::pair<Point, IncidentEdges>;
  public:
     EdgeMap() = default;
-    EdgeMap(const EdgeSet &edge_set);
 
-    std::optional<Points> insert(const Edge &edge);
-    std::optional<Points> insert(const Edges &edges);
-    Edge pop_edge();
-    std::optional<Edges> pop_edges(const Points &points);
+    // duplicates are ignored.
+    void insert(const Edge &edge);
 
-    bool empty() const { return map_.empty(); }
-    const auto &map() const { return map_; }
+    bool empty() const { return entries_.empty(); }
+    // (point, edges of point), in order of first insertion.
+    const std::vector<Entry> &map() const { return entries_; }
 
     size_t edge_count() const { return edge_count_; }
 
  private:
-    std::optional<Edges> pop_edges(const Point &i);
-
-    // Returns true if i is new.
-    bool insert(primitives::point_id_t i, const Edge &edge);
-
-    // remove edge entries for both points in the edge.
-    void remove_edges(const Edge &edge);
-    void remove_edge(primitives::point_id_t i, const Edge &edge);
-
-    // Maps each point to the edges that said point is a part of. Each edge is stored twice, once for each point.
-    std::unordered_map<Point, IncidentEdges> map_;
+    // maps up to this many points are searched linearly.
+    static constexpr size_t MAX_LINEAR{8};
+    static constexpr uint32_t EMPTY_SLOT{0};
+
+    void insert(primitives::point_id_t i, const Edge &edge);
+    // the entry of i, or entries_.size() if there is none; also gives the table slot for a new entry.
+    size_t find(primitives::point_id_t i, size_t &slot) const;
+    void rehash(size_t slots);
+
+    // each point's edges. Each edge is stored twice, once for each point.
+    std::vector<Entry> entries_;
+    // entry index + 1 at the slot of each point, EMPTY_SLOT where there is none; empty while the map is small.
+    std::vector<uint32_t> slots_;
 
     size_t edge_count_{0};
 
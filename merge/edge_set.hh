@@ -1,12 +0,0 @@
-#pragma once
-
-#include "edge.hh"
-
-#include <set>
-
-namespace merge {
-
-using EdgeSet = std::set<Edge>;
-
-}  // namespace merge
-
@@ -1,19 +1,34 @@
 #include "exchange_pair.hh"
 
+#include <tour.hh>
+
 namespace merge {
 
-int ExchangePair::compute_improvement(const std::vector<primitives::space_t> &x, const std::vector<primitives::space_t> &y) {
+template <typename EdgePair>
+int ExchangePair::cost(const EdgePair &edge_pair, const Tour &tour) const {
+    int cost{0};
+    const auto &first_edge = edge_pair.first;
+    if (first_edge) {
+        cost += tour.length(first_edge->first, first_edge->second);
+    }
+    const auto &second_edge = edge_pair.second;
+    if (second_edge) {
+        cost += tour.length(second_edge->first, second_edge->second);
+    }
+    return cost;
+}
+
+int ExchangePair::compute_improvement(const Tour &tour) {
     if (improvement) {
         return *improvement;
     }
-    LengthCalculator calc(x, y);
     improvement = std::make_optional<int>(0);
     // note that each edge has 2 entries in the map.
     for (const auto &pair : current.map()) {
-        *improvement += cost(pair.second, calc);
+        *improvement += cost(pair.second, tour);
     }
     for (const auto &pair : candidate.map()) {
-        *improvement -= cost(pair.second, calc);
+        *improvement -= cost(pair.second, tour);
     }
     if ((*improvement & 1) == 1) { // odd
         throw std::logic_error("2x the improvement is an odd number.");
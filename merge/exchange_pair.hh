@@ -7,7 +7,7 @@
 #include <iostream>
 #include <primitives.hh>
 
-#include <length_calculator.hh>
+class Tour;
 
 namespace merge {
 
@@ -16,7 +16,8 @@ struct ExchangePair {
     std::optional<int> improvement{std::nullopt};
 
     bool empty() const { return current.empty() and candidate.empty(); }
-    int compute_improvement(const std::vector<primitives::space_t> &x, const std::vector<primitives::space_t> &y);
+    // edge lengths are measured with the metric of tour.
+    int compute_improvement(const Tour &tour);
 
     size_t edge_count() const {
         if (current.edge_count() != candidate.edge_count()) {
@@ -28,22 +29,8 @@ struct ExchangePair {
 
  private:
     template <typename EdgePair>
-    int cost(const EdgePair &edge_pair, const LengthCalculator &calc) const;
+    int cost(const EdgePair &edge_pair, const Tour &tour) const;
 };
 
-template <typename EdgePair>
-int ExchangePair::cost(const EdgePair &edge_pair, const LengthCalculator &calc) const {
-    int cost{0};
-    const auto &first_edge = edge_pair.first;
-    if (first_edge) {
-        cost += calc(first_edge->first, first_edge->second);
-    }
-    const auto &second_edge = edge_pair.second;
-    if (second_edge) {
-        cost += calc(second_edge->first, second_edge->second);
-    }
-    return cost;
-}
-
 }  // namespace merge
 
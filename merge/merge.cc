@@ -5,22 +5,123 @@
 #include "exchange_pair.hh"
 #include "combinator.hh"
 #include "cycle_util.hh"
+#include "union_find.hh"
 #include <kmove.hh>
-#include <length_calculator.hh>
 #include <cycle_check.hh>
+#include <diagnostics.hh>
+#include <multicycle_tour.hh>
+#include <parallel.hh>
 
-#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <tuple>
 
 namespace merge {
 
 namespace {
 
-template <typename AdjacentsContainer>
-std::pair<primitives::point_id_t, primitives::point_id_t> sorted_pair(
-    const AdjacentsContainer &adjacents,
-    primitives::point_id_t i) {
-    const auto &a = adjacents[i];
-    return {std::min(a[0], a[1]), std::max(a[0], a[1])};
+// below this many points per block, thread startup costs more than the scan.
+constexpr size_t MIN_DIFF_BLOCK{1 << 16};
+
+// one "i j" line per edge.
+std::string edge_list(const EdgeKeys &keys) {
+    std::ostringstream list;
+    for (auto key : keys) {
+        const auto edge = unpack(key);
+        list << edge.first << ' ' << edge.second << '\n';
+    }
+    return list.str();
+}
+
+EdgeKeys concatenate(std::vector<EdgeKeys> &blocks) {
+    size_t size{0};
+    for (const auto &block : blocks) {
+        size += block.size();
+    }
+    EdgeKeys keys;
+    keys.reserve(size);
+    for (const auto &block : blocks) {
+        keys.insert(std::cend(keys), std::cbegin(block), std::cend(block));
+    }
+    return keys;
+}
+
+// two-cycle combos tried for a patch, most extra improvement first.
+constexpr size_t MAX_REPAIR_CANDIDATES{8};
+// the smaller cycle is only patched up to this many points.
+constexpr size_t MAX_REPAIR_CYCLE{1000};
+// nearest points tried as patch partners of each point of the smaller cycle.
+constexpr size_t REPAIR_NEIGHBORS{8};
+
+// a move that joins two cycles, and its length change.
+struct Patch {
+    KMove kmove;
+    int cost{0};
+};
+
+// Finds the cheapest 2-opt move that joins the two cycles left by applying kmove to tour:
+// removes an edge (p, x) of the smaller cycle and an edge (r, y) of the other, with r near p,
+// and adds (p, r) and (x, y). Only edges of tour are removed, so the patch can be added to kmove.
+std::optional<Patch> join_cycles(const Tour &tour, const KMove &kmove, const SpatialIndex &spatial_index) {
+    MulticycleTour cycles(tour);
+    cycles.multicycle_swap(kmove);
+    if (cycles.cycles() != 2 or cycles.min_cycle_size() > MAX_REPAIR_CYCLE) {
+        return std::nullopt;
+    }
+    std::vector<primitives::point_id_t> first_cycle;
+    for (primitives::point_id_t i{0}; i < cycles.size(); ++i) {
+        if (cycles.cycle_id(i) == 0) {
+            first_cycle.push_back(i);
+        }
+    }
+    const primitives::cycle_id_t small_cycle = first_cycle.size() == cycles.min_cycle_size() ? 0 : 1;
+    std::vector<primitives::point_id_t> small_points;
+    if (small_cycle == 0) {
+        small_points = std::move(first_cycle);
+    } else {
+        for (primitives::point_id_t i{0}; i < cycles.size(); ++i) {
+            if (cycles.cycle_id(i) == small_cycle) {
+                small_points.push_back(i);
+            }
+        }
+    }
+    const auto in_tour = [&tour](primitives::point_id_t a, primitives::point_id_t b) {
+        return tour.next(a) == b or tour.next(b) == a;
+    };
+    const auto length = [&tour](primitives::point_id_t a, primitives::point_id_t b) {
+        return static_cast<int>(tour.length(a, b));
+    };
+    std::optional<Patch> best;
+    for (auto p : small_points) {
+        for (auto r : spatial_index.knn(p, REPAIR_NEIGHBORS)) {
+            if (cycles.cycle_id(r) == small_cycle or in_tour(p, r)) {
+                continue;
+            }
+            for (auto x : {cycles.prev(p), cycles.next(p)}) {
+                // edges added by kmove cannot be removed again.
+                if (not in_tour(p, x)) {
+                    continue;
+                }
+                for (auto y : {cycles.prev(r), cycles.next(r)}) {
+                    if (not in_tour(r, y) or in_tour(x, y)) {
+                        continue;
+                    }
+                    const auto cost = length(p, r) + length(x, y) - length(p, x) - length(r, y);
+                    if (best and cost >= best->cost) {
+                        continue;
+                    }
+                    // removes are given by the first point of the edge in tour order, as in perturb::random_cycle_merge_move.
+                    KMove patch;
+                    patch.removes = {tour.next(p) == x ? p : x, tour.next(r) == y ? r : y};
+                    patch.starts = {p, x};
+                    patch.ends = {r, y};
+                    best = Patch{std::move(patch), cost};
+                }
+            }
+        }
+    }
+    return best;
 }
 
 // checks if input set is an incrementing sequence duplicates are accepted.
@@ -51,87 +152,191 @@ bool is_sequence(std::vector<primitives::point_id_t> &point_container, primitive
 
 }  // namespace
 
-std::pair<EdgeSet, EdgeSet> edge_differences(const Tour &tour1, const Tour &tour2) {
+ExchangeSet edge_differences(const Tour &tour1, const Tour &tour2) {
     const auto &adjacents1 = tour1.adjacents();
     const auto &adjacents2 = tour2.adjacents();
-    EdgeSet diff1, diff2;
-    for (primitives::point_id_t i{0}; i < adjacents1.size(); ++i) {
-        const auto &sorted1 = sorted_pair(adjacents1, i);
-        const auto &sorted2 = sorted_pair(adjacents2, i);
-        if (sorted1 == sorted2) {
-            continue;
-        }
-        const auto diff11 = sorted1.first != sorted2.first;
-        const auto diff12 = sorted1.first != sorted2.second;
-        const auto diff21 = sorted1.second != sorted2.first;
-        const auto diff22 = sorted1.second != sorted2.second;
-        if (diff11 and diff12) {
-            const auto j = sorted1.first;
-            diff1.emplace(std::min(i, j), std::max(i, j));
-        }
-        if (diff21 and diff22) {
-            const auto j = sorted1.second;
-            diff1.emplace(std::min(i, j), std::max(i, j));
-        }
-        if (diff11 and diff21) {
-            const auto j = sorted2.first;
-            diff2.emplace(std::min(i, j), std::max(i, j));
-        }
-        if (diff12 and diff22) {
-            const auto j = sorted2.second;
-            diff2.emplace(std::min(i, j), std::max(i, j));
-        }
+    if (adjacents1.size() != adjacents2.size()) {
+        throw std::logic_error("tours have different point counts.");
     }
+    const auto size = adjacents1.size();
+    const auto threads = std::min(parallel::thread_count(), size / MIN_DIFF_BLOCK + 1);
+    std::vector<EdgeKeys> diffs1(parallel::block_count(size, threads));
+    std::vector<EdgeKeys> diffs2(diffs1.size());
+    parallel::blocks(size, [&](size_t block, size_t begin, size_t end) {
+        auto &diff1 = diffs1[block];
+        auto &diff2 = diffs2[block];
+        for (auto i = static_cast<primitives::point_id_t>(begin); i < end; ++i) {
+            const auto &a1 = adjacents1[i];
+            const auto &a2 = adjacents2[i];
+            // each edge is seen from both of its points; only the lower one emits it.
+            for (auto j : a1) {
+                if (j > i and j != a2[0] and j != a2[1]) {
+                    diff1.push_back(pack(i, j));
+                }
+            }
+            for (auto j : a2) {
+                if (j > i and j != a1[0] and j != a1[1]) {
+                    diff2.push_back(pack(i, j));
+                }
+            }
+        }
+    }, threads);
+    auto diff1 = concatenate(diffs1);
+    auto diff2 = concatenate(diffs2);
     if (diff2.size() != diff1.size()) {
         throw std::logic_error("number of different edges are not the same between tours.");
     }
     return {std::move(diff1), std::move(diff2)};
 }
 
-ExchangePair disjoin(ExchangePair &base) {
-    ExchangePair disjoined;
-    auto new_points = disjoined.current.insert({base.current.pop_edge()});
-    while (new_points) {
-        new_points = disjoined.candidate.insert(*base.candidate.pop_edges(*new_points));
-        if (not new_points) {
-            break;
+ExchangeSet edge_differences(const Tour &tour1, const std::vector<primitives::point_id_t> &next2) {
+    const auto &adjacents1 = tour1.adjacents();
+    if (adjacents1.size() != next2.size()) {
+        throw std::logic_error("tours have different point counts.");
+    }
+    const auto size = adjacents1.size();
+    const auto threads = std::min(parallel::thread_count(), size / MIN_DIFF_BLOCK + 1);
+    std::vector<EdgeKeys> diffs1(parallel::block_count(size, threads));
+    std::vector<EdgeKeys> diffs2(diffs1.size());
+    parallel::blocks(size, [&](size_t block, size_t begin, size_t end) {
+        auto &diff1 = diffs1[block];
+        auto &diff2 = diffs2[block];
+        for (auto i = static_cast<primitives::point_id_t>(begin); i < end; ++i) {
+            const auto &a1 = adjacents1[i];
+            // (i, j) is in tour2 iff one of its points is next to the other.
+            for (auto j : a1) {
+                if (j > i and next2[i] != j and next2[j] != i) {
+                    diff1.push_back(pack(i, j));
+                }
+            }
+            // each edge of tour2 is (i, next2[i]) for exactly one i.
+            const auto j = next2[i];
+            if (j != a1[0] and j != a1[1]) {
+                diff2.push_back(pack(i, j));
+            }
         }
-        new_points = disjoined.current.insert(*base.current.pop_edges(*new_points));
+    }, threads);
+    auto diff1 = concatenate(diffs1);
+    auto diff2 = concatenate(diffs2);
+    if (diff2.size() != diff1.size()) {
+        throw std::logic_error("number of different edges are not the same between tours.");
     }
-    return disjoined;
+    return {std::move(diff1), std::move(diff2)};
 }
 
-std::vector<ExchangePair> disjoin(const EdgeSet &current_edges, const EdgeSet &candidate_edges) {
-    EdgeMap current(current_edges);
-    EdgeMap candidate(candidate_edges);
-    ExchangePair base{std::move(current), std::move(candidate)};
+std::vector<ExchangePair> disjoin(const EdgeKeys &current, const EdgeKeys &candidate) {
+    // union-find over the (sorted, unique) points of the differing edges.
+    std::vector<primitives::point_id_t> points;
+    points.reserve(2 * (current.size() + candidate.size()));
+    for (const auto *keys : {&current, &candidate}) {
+        for (auto key : *keys) {
+            const auto edge = unpack(key);
+            points.push_back(edge.first);
+            points.push_back(edge.second);
+        }
+    }
+    std::sort(std::begin(points), std::end(points));
+    points.erase(std::unique(std::begin(points), std::end(points)), std::end(points));
+    const auto index = [&points](primitives::point_id_t point) {
+        return static_cast<size_t>(std::lower_bound(std::cbegin(points), std::cend(points), point) - std::cbegin(points));
+    };
+    UnionFind components(points.size());
+    for (const auto *keys : {&current, &candidate}) {
+        for (auto key : *keys) {
+            const auto edge = unpack(key);
+            components.unite(index(edge.first), index(edge.second));
+        }
+    }
+    // exchange pairs are numbered by the first appearance of their component.
+    constexpr size_t NONE{std::numeric_limits<size_t>::max()};
+    std::vector<size_t> exchange_index(points.size(), NONE);
     std::vector<ExchangePair> exchange_pairs;
-    while (not base.empty()) {
-        exchange_pairs.push_back(disjoin(base));
+    const auto exchange_pair = [&](const Edge &edge) -> ExchangePair & {
+        auto &e = exchange_index[components.find(index(edge.first))];
+        if (e == NONE) {
+            e = exchange_pairs.size();
+            exchange_pairs.emplace_back();
+        }
+        return exchange_pairs[e];
+    };
+    for (auto key : current) {
+        const auto edge = unpack(key);
+        exchange_pair(edge).current.insert(edge);
+    }
+    for (auto key : candidate) {
+        const auto edge = unpack(key);
+        exchange_pair(edge).candidate.insert(edge);
     }
     return exchange_pairs;
 }
 
-std::optional<KMove> merge(Tour &current_tour, const Tour &candidate_tour) {
-    const auto [old_edges, new_edges] = merge::edge_differences(current_tour, candidate_tour);
-    if (old_edges.size() != new_edges.size()) {
-        throw std::logic_error("edge diff set does not comprise of the same number of edges from both tours.");
-    }
-    std::cout << "edge diff count: " << old_edges.size() << std::endl;
-    if (old_edges.empty()) {
-        return std::nullopt;
+std::vector<std::vector<size_t>> interleaved_groups(const Tour &tour, const std::vector<ExchangePair> &exchange_pairs) {
+    // (sequence, exchange) of each removed edge, in tour order.
+    std::vector<std::pair<primitives::sequence_t, size_t>> cuts;
+    std::vector<size_t> remaining(exchange_pairs.size(), 0);
+    for (size_t e{0}; e < exchange_pairs.size(); ++e) {
+        for (const auto &pair : exchange_pairs[e].current.map()) {
+            for (const auto *edge : {&pair.second.first, &pair.second.second}) {
+                // each edge is stored for both of its points.
+                if (*edge and (*edge)->first == pair.first) {
+                    const auto normalized = cycle_util::normalize_edge(tour, **edge);
+                    cuts.emplace_back(tour.sequence(normalized.first, 0), e);
+                    ++remaining[e];
+                }
+            }
+        }
     }
-
-    std::ofstream old_edge_file("output/old_edges.txt", std::ofstream::out);
-    for (const auto &e : old_edges) {
-        old_edge_file << e.first << ' ' << e.second << std::endl;
+    std::sort(std::begin(cuts), std::end(cuts));
+    // the open groups (seen, with cuts still to come) form a stack, in order of first cut.
+    // A cut of an open group interleaves it with every open group above it, which started since and continues after.
+    UnionFind groups(exchange_pairs.size());
+    std::vector<size_t> open;
+    std::vector<char> is_open(exchange_pairs.size(), false);
+    for (const auto &cut : cuts) {
+        auto group = groups.find(cut.second);
+        if (is_open[group]) {
+            const auto stacked = group;
+            while (open.back() != stacked) {
+                const auto above = open.back();
+                open.pop_back();
+                is_open[above] = false;
+                is_open[group] = false;
+                const auto total = remaining[group] + remaining[above];
+                groups.unite(group, above);
+                group = groups.find(group);
+                remaining[group] = total;
+                is_open[group] = true;
+            }
+            open.back() = group;
+        } else {
+            open.push_back(group);
+            is_open[group] = true;
+        }
+        if (--remaining[group] == 0) {
+            open.pop_back();
+            is_open[group] = false;
+        }
     }
-    std::ofstream new_edge_file("output/new_edges.txt", std::ofstream::out);
-    for (const auto &e : new_edges) {
-        new_edge_file << e.first << ' ' << e.second << std::endl;
+    std::vector<std::vector<size_t>> interleaved;
+    std::vector<size_t> group_index(exchange_pairs.size(), exchange_pairs.size());
+    for (size_t e{0}; e < exchange_pairs.size(); ++e) {
+        auto &index = group_index[groups.find(e)];
+        if (index == exchange_pairs.size()) {
+            index = interleaved.size();
+            interleaved.emplace_back();
+        }
+        interleaved[index].push_back(e);
     }
+    return interleaved;
+}
+
+namespace {
 
-    auto exchanges = disjoin(old_edges, new_edges);
+// Applies the best single-cycle combination of exchange pairs (which share no points) to current_tour.
+std::optional<KMove> apply_exchanges(Tour &current_tour
+    , std::vector<ExchangePair> exchanges
+    , const SpatialIndex &spatial_index
+    , CombinatorBudget budget) {
     if (exchanges.empty()) {
         return std::nullopt;
     }
@@ -140,16 +345,16 @@ std::optional<KMove> merge(Tour &current_tour, const Tour &candidate_tour) {
 
     // compute improvements for each exchange.
     std::sort(std::begin(exchanges), std::end(exchanges), [&current_tour](auto &lhs, auto &rhs) {
-        return lhs.compute_improvement(current_tour.x(), current_tour.y()) > rhs.compute_improvement(current_tour.x(), current_tour.y());
+        return lhs.compute_improvement(current_tour) > rhs.compute_improvement(current_tour);
     });
 
-    if (exchanges.front().compute_improvement(current_tour.x(), current_tour.y()) < 0) {
+    if (exchanges.front().compute_improvement(current_tour) < 0) {
         return std::nullopt;
     }
 
     // check to see if exchange pair is useless, meaning zero-cost and non-cycle-breaking.
     // returns true if useless, e.g. should be excluded.
-    const auto useless = [&current_tour, &candidate_tour](const ExchangePair &ex) {
+    const auto useless = [&current_tour](const ExchangePair &ex) {
         if (*ex.improvement > 0) {
             return false;
         }
@@ -159,40 +364,219 @@ std::optional<KMove> merge(Tour &current_tour, const Tour &candidate_tour) {
             sequence.push_back(current_tour.sequence(pair.first, START_POINT));
         }
         std::sort(std::begin(sequence), std::end(sequence));
-        return is_sequence(sequence, current_tour.size()) or !cycle_util::breaks_cycle(current_tour, candidate_tour, ex);
+        return is_sequence(sequence, current_tour.size()) or !cycle_util::breaks_cycle(current_tour, ex);
     };
     exchanges.erase(std::remove_if(std::begin(exchanges), std::end(exchanges), useless), std::end(exchanges));
     // max gain, exclude too-low edges.
     const int max_total_improvement = std::accumulate(std::cbegin(exchanges), std::cend(exchanges), int(0), [](int sum, const auto &ex) { return sum + std::max(*ex.improvement, 0); });
-    std::cout << "max total improvement: " << max_total_improvement << std::endl;
     exchanges.erase(std::remove_if(std::begin(exchanges), std::end(exchanges), [max_total_improvement](const auto &ex) { return *ex.improvement + max_total_improvement <= 0; }), std::end(exchanges));
-    std::cout << "removed " << original_exchange_size - exchanges.size() << " useless exchange(s).\n";
-    std::cout << exchanges.size() << " distinct exchange(s)." << std::endl;
-    size_t i{0};
-    for (auto &ex : exchanges) {
-        std::cout << i << ": improvement: " << ex.compute_improvement(current_tour.x(), current_tour.y()) << " ("
-            << ex.edge_count() << " edges, breaks cycle: "
-            << cycle_util::breaks_cycle(current_tour, candidate_tour, ex) << ")" << std::endl;
-        ++i;
-    }
-
-    Combinator combinator(exchanges, current_tour, candidate_tour);
-    combinator.find();
-    std::cout << "move combos checked: " << combinator.checks() << std::endl;
-    if (combinator.viable_count() > 0) {
-        std::cout << "viable combos: " << combinator.viable_count() << std::endl;
-    }
-    if (combinator.best_combo()) {
-        const auto old_length = current_tour.length();
-        const auto &kmove = cycle_util::to_kmove(current_tour, candidate_tour, exchanges, *combinator.best_combo());
-        current_tour.swap(kmove);
-        const auto new_length = current_tour.length();
-        if (static_cast<int>(old_length) - static_cast<int>(new_length) != *combinator.best_improvement()) {
-            throw std::logic_error("Tour length after swap is inconsistent with expected improvement.");
-        }
-        return kmove;
-    }
-    return std::nullopt;
+    if (diagnostics::enabled(diagnostics::Level::DETAIL)) {
+        diagnostics::Message() << "max total improvement: " << max_total_improvement;
+        diagnostics::Message() << "removed " << original_exchange_size - exchanges.size() << " useless exchange(s).";
+    }
+    if (diagnostics::enabled(diagnostics::Level::SUMMARY)) {
+        diagnostics::Message() << exchanges.size() << " distinct exchange(s).";
+    }
+    if (exchanges.empty()) {
+        return std::nullopt;
+    }
+
+    int improvement{0};
+    size_t independent{0};
+    size_t checks{0};
+    const auto groups = interleaved_groups(current_tour, exchanges);
+    // exchanges chosen from each group.
+    std::vector<std::vector<size_t>> chosen(groups.size());
+    // a combo of one group that leaves two cycles but improves more than the group's choice (its baseline).
+    struct Repair {
+        size_t group;
+        int improvement;
+        int baseline;
+        std::vector<size_t> combo;
+    };
+    std::vector<Repair> repairs;
+    for (size_t g{0}; g < groups.size(); ++g) {
+        const auto &group = groups[g];
+        if (group.size() == 1) {
+            const auto &ex = exchanges[group.front()];
+            if (*ex.improvement > 0) {
+                const auto cycles = cycle_util::count_cycles(current_tour, exchanges, group);
+                if (cycles == 1) {
+                    chosen[g] = group;
+                    improvement += *ex.improvement;
+                    ++independent;
+                } else if (cycles == 2) {
+                    repairs.push_back({g, *ex.improvement, 0, group});
+                }
+            }
+            continue;
+        }
+        std::vector<ExchangePair> grouped;
+        for (auto e : group) {
+            grouped.push_back(exchanges[e]);
+        }
+        Combinator combinator(grouped, current_tour, budget);
+        combinator.find();
+        checks += combinator.checks();
+        if (diagnostics::enabled(diagnostics::Level::DETAIL)) {
+            diagnostics::Message() << "group of " << group.size() << " exchange(s): " << combinator.checks() << " combos checked"
+                << (combinator.exhausted() ? " (budget exhausted)" : "") << ", best improvement: "
+                << combinator.best_improvement().value_or(0);
+        }
+        const auto baseline = combinator.best_improvement().value_or(0);
+        if (combinator.best_combo()) {
+            for (auto i : *combinator.best_combo()) {
+                chosen[g].push_back(group[i]);
+            }
+            improvement += baseline;
+        }
+        for (const auto &[two_cycle_improvement, two_cycle_combo] : combinator.two_cycle_combos()) {
+            if (two_cycle_improvement > baseline) {
+                std::vector<size_t> global_combo;
+                for (auto i : two_cycle_combo) {
+                    global_combo.push_back(group[i]);
+                }
+                repairs.push_back({g, two_cycle_improvement, baseline, std::move(global_combo)});
+            }
+        }
+    }
+    if (diagnostics::enabled(diagnostics::Level::SUMMARY)) {
+        diagnostics::Message() << groups.size() << " interleaved group(s); applied " << independent << " independent exchange(s).";
+        diagnostics::Message() << "move combos checked: " << checks;
+    }
+
+    const auto combine = [&chosen](std::optional<size_t> replaced_group, const std::vector<size_t> &replacement) {
+        std::vector<size_t> combo(replacement);
+        for (size_t g{0}; g < chosen.size(); ++g) {
+            if (not replaced_group or g != *replaced_group) {
+                combo.insert(std::cend(combo), std::cbegin(chosen[g]), std::cend(chosen[g]));
+            }
+        }
+        std::sort(std::begin(combo), std::end(combo));
+        return combo;
+    };
+    auto combo = combine(std::nullopt, {});
+
+    // patch the most promising two-cycle combos; keep the one that adds the most improvement after its patch.
+    std::stable_sort(std::begin(repairs), std::end(repairs), [](const auto &lhs, const auto &rhs) {
+        return lhs.improvement - lhs.baseline > rhs.improvement - rhs.baseline;
+    });
+    if (repairs.size() > MAX_REPAIR_CANDIDATES) {
+        repairs.resize(MAX_REPAIR_CANDIDATES);
+    }
+    int repair_gain{0};
+    std::optional<KMove> repair_patch;
+    std::vector<size_t> repaired_combo;
+    for (const auto &repair : repairs) {
+        if (repair.improvement - repair.baseline <= repair_gain) {
+            // patches usually add length, so this repair likely gains less.
+            break;
+        }
+        auto repaired = combine(repair.group, repair.combo);
+        const auto patch = join_cycles(current_tour, cycle_util::to_kmove(current_tour, exchanges, repaired), spatial_index);
+        if (not patch) {
+            continue;
+        }
+        const auto gain = repair.improvement - patch->cost - repair.baseline;
+        if (gain > repair_gain) {
+            repair_gain = gain;
+            repair_patch = patch->kmove;
+            repaired_combo = std::move(repaired);
+        }
+    }
+    if (diagnostics::enabled(diagnostics::Level::SUMMARY)) {
+        diagnostics::Message() << repairs.size() << " two-cycle combo(s) considered for a patch; added improvement: " << repair_gain;
+    }
+    if (repair_patch) {
+        combo = std::move(repaired_combo);
+        improvement += repair_gain;
+    }
+    if (combo.empty()) {
+        return std::nullopt;
+    }
+    const auto old_length = current_tour.length();
+    auto kmove = cycle_util::to_kmove(current_tour, exchanges, combo);
+    if (repair_patch) {
+        kmove += *repair_patch;
+    }
+    if (cycle_check::breaks_cycle(current_tour, kmove)) {
+        throw std::logic_error("best exchange combination does not form a single cycle.");
+    }
+    current_tour.swap(kmove);
+    const auto new_length = current_tour.length();
+    if (static_cast<int>(old_length) - static_cast<int>(new_length) != improvement) {
+        throw std::logic_error("Tour length after swap is inconsistent with expected improvement.");
+    }
+    return kmove;
+}
+
+}  // namespace
+
+std::optional<KMove> merge(Tour &current_tour
+    , const Tour &candidate_tour
+    , const SpatialIndex &spatial_index
+    , CombinatorBudget budget) {
+    const auto [old_edges, new_edges] = merge::edge_differences(current_tour, candidate_tour);
+    if (old_edges.size() != new_edges.size()) {
+        throw std::logic_error("edge diff set does not comprise of the same number of edges from both tours.");
+    }
+    if (diagnostics::enabled(diagnostics::Level::SUMMARY)) {
+        diagnostics::Message() << "edge diff count: " << old_edges.size();
+    }
+    if (old_edges.empty()) {
+        return std::nullopt;
+    }
+    if (diagnostics::enabled(diagnostics::Level::DETAIL)) {
+        diagnostics::write_file("output/old_edges.txt", edge_list(old_edges));
+        diagnostics::write_file("output/new_edges.txt", edge_list(new_edges));
+    }
+
+    return apply_exchanges(current_tour, disjoin(old_edges, new_edges), spatial_index, budget);
+}
+
+std::optional<KMove> merge(Tour &current_tour
+    , const Pool &pool
+    , const SpatialIndex &spatial_index
+    , CombinatorBudget budget) {
+    // (improvement, pool frequency of new edges, parent exchange) of the exchange pairs of every parent.
+    std::vector<ExchangePair> parent_exchanges;
+    std::vector<std::tuple<int, size_t, size_t>> ranked;
+    for (size_t t{0}; t < pool.size(); ++t) {
+        const auto [old_edges, new_edges] = edge_differences(current_tour, pool.next(t));
+        for (auto &ex : disjoin(old_edges, new_edges)) {
+            size_t frequency{0};
+            for (const auto &edge : cycle_util::edges(ex.candidate)) {
+                frequency += pool.frequency(edge.first, edge.second);
+            }
+            ranked.emplace_back(ex.compute_improvement(current_tour), frequency, parent_exchanges.size());
+            parent_exchanges.push_back(std::move(ex));
+        }
+    }
+    std::sort(std::begin(ranked), std::end(ranked), [](const auto &lhs, const auto &rhs) {
+        return std::tie(std::get<0>(lhs), std::get<1>(lhs)) > std::tie(std::get<0>(rhs), std::get<1>(rhs));
+    });
+    std::vector<char> taken(current_tour.size(), false);
+    std::vector<ExchangePair> exchanges;
+    for (const auto &rank : ranked) {
+        auto &ex = parent_exchanges[std::get<2>(rank)];
+        // the removed and added edges of an exchange pair have the same points.
+        const auto &points = ex.current.map();
+        const auto overlaps = std::any_of(std::cbegin(points), std::cend(points), [&taken](const auto &pair) {
+            return taken[pair.first];
+        });
+        if (overlaps) {
+            continue;
+        }
+        for (const auto &pair : points) {
+            taken[pair.first] = true;
+        }
+        exchanges.push_back(std::move(ex));
+    }
+    if (diagnostics::enabled(diagnostics::Level::SUMMARY)) {
+        diagnostics::Message() << "pool of " << pool.size() << " parent(s): " << parent_exchanges.size() << " exchange(s), "
+            << parent_exchanges.size() - exchanges.size() << " overlapping dropped.";
+    }
+    return apply_exchanges(current_tour, std::move(exchanges), spatial_index, budget);
 }
 
 }  // namespace merge
@@ -1,7 +1,10 @@
 #pragma once
 
-#include "edge_set.hh"
+#include "combinator.hh"
+#include "edge.hh"
 #include "exchange_pair.hh"
+#include "pool.hh"
+#include "spatial_index.hh"
 #include "tour.hh"
 #include "primitives.hh"
 
@@ -13,14 +16,38 @@
 
 namespace merge {
 
-using ExchangeSet = std::pair<EdgeSet, EdgeSet>;
-
-std::pair<EdgeSet, EdgeSet> edge_differences(const Tour &tour1, const Tour &tour2);
-
-// Removes a disjoint ExchangePair from base.
-ExchangePair disjoin(ExchangePair &base);
-std::vector<ExchangePair> disjoin(const EdgeSet &current, const EdgeSet &candidate);
-
-std::optional<KMove> merge(Tour &current_tour, const Tour &candidate_tour);
+using ExchangeSet = std::pair<EdgeKeys, EdgeKeys>;
+
+// Returns the edges of tour1 that are not in tour2, and those of tour2 not in tour1.
+// Large tours are scanned in parallel blocks of points.
+ExchangeSet edge_differences(const Tour &tour1, const Tour &tour2);
+// As above, with tour2 given by the next point of each point (e.g. a tour of a Pool).
+ExchangeSet edge_differences(const Tour &tour1, const std::vector<primitives::point_id_t> &next2);
+
+// Splits the differences into exchange pairs that share no points:
+// the connected components of the graph of all differing edges.
+std::vector<ExchangePair> disjoin(const EdgeKeys &current, const EdgeKeys &candidate);
+
+// Groups exchange pairs whose removed edges interleave in tour order (x..y..x..y), directly or through other pairs.
+// A subset of exchange pairs forms a single cycle iff its part in each group does on its own,
+// so groups can be decided separately. Groups list indices into exchange_pairs, in ascending order.
+std::vector<std::vector<size_t>> interleaved_groups(const Tour &tour, const std::vector<ExchangePair> &exchange_pairs);
+
+// Exchange pairs that interleave with no other are applied if they improve the tour and keep it a single cycle;
+// the best combination of each larger group is searched for within budget.
+// Combinations that improve more but leave two cycles are kept if a 2-opt patch between the cycles,
+// found from the nearest points of spatial_index, costs less than the extra improvement.
+std::optional<KMove> merge(Tour &current_tour
+    , const Tour &candidate_tour
+    , const SpatialIndex &spatial_index
+    , CombinatorBudget budget = {});
+
+// Multi-parent merge: decomposes the differences of every tour of pool from current_tour at once.
+// Exchange pairs of different parents may share points; the one with the higher improvement
+// (then with new edges more frequent in the pool) is kept, and the kept ones are combined as above.
+std::optional<KMove> merge(Tour &current_tour
+    , const Pool &pool
+    , const SpatialIndex &spatial_index
+    , CombinatorBudget budget = {});
 
 }  // namespace merge
@@ -0,0 +1,110 @@
+#include "pool.hh"
+
+#include <algorithm> // count_if, find_if
+#include <cstddef> // ptrdiff_t
+
+namespace merge {
+
+bool Pool::add(const Tour &tour) {
+    if (capacity_ == 0 or contains(tour)) {
+        return false;
+    }
+    const auto length = tour.length();
+    if (not full()) {
+        next_.push_back(tour.next());
+        lengths_.push_back(length);
+        hashes_.push_back(tour.hash());
+        count_edges(next_.size() - 1, true);
+        return true;
+    }
+    const auto oldest = oldest_;
+    oldest_ = (oldest_ + 1) % capacity_;
+    count_edges(oldest, false);
+    next_[oldest] = tour.next();
+    lengths_[oldest] = length;
+    hashes_[oldest] = tour.hash();
+    count_edges(oldest, true);
+    return true;
+}
+
+uint32_t Pool::frequency(primitives::point_id_t i, primitives::point_id_t j) const {
+    if (used_.empty()) {
+        return 0;
+    }
+    const auto begin = std::cbegin(neighbors_) + static_cast<std::ptrdiff_t>(2 * capacity_ * i);
+    const auto end = begin + used_[i];
+    const auto it = std::find_if(begin, end, [j](const auto &neighbor) { return neighbor.point == j; });
+    return it == end ? 0 : it->count;
+}
+
+size_t Pool::common_edges() const {
+    const auto tours = static_cast<uint32_t>(size());
+    size_t common{0};
+    for (primitives::point_id_t i{0}; i < used_.size(); ++i) {
+        const auto begin = std::cbegin(neighbors_) + static_cast<std::ptrdiff_t>(2 * capacity_ * i);
+        // each edge is counted at both of its points; only the lower one counts it here.
+        common += static_cast<size_t>(std::count_if(begin, begin + used_[i], [i, tours](const auto &neighbor) {
+            return neighbor.point > i and neighbor.count == tours;
+        }));
+    }
+    return common;
+}
+
+bool Pool::contains(const Tour &tour) const {
+    // a tour has the same edges as another if each point is next to its next point in the other;
+    // only checked for equal hashes.
+    for (size_t t{0}; t < next_.size(); ++t) {
+        if (hashes_[t] != tour.hash()) {
+            continue;
+        }
+        const auto &next = next_[t];
+        bool same{true};
+        for (primitives::point_id_t i{0}; i < next.size() and same; ++i) {
+            same = next[i] == tour.next(i) or next[tour.next(i)] == i;
+        }
+        if (same) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Pool::count_edges(size_t t, bool add) {
+    const auto &next = next_[t];
+    if (used_.empty()) {
+        neighbors_.resize(2 * capacity_ * next.size());
+        used_.resize(next.size(), 0);
+    }
+    for (primitives::point_id_t i{0}; i < next.size(); ++i) {
+        const bool changed {count_neighbor(i, next[i], add)};
+        count_neighbor(next[i], i, add);
+        if (changed) {
+            add ? ++distinct_edges_ : --distinct_edges_;
+        }
+    }
+}
+
+bool Pool::count_neighbor(primitives::point_id_t i, primitives::point_id_t j, bool add) {
+    const auto begin = std::begin(neighbors_) + static_cast<std::ptrdiff_t>(2 * capacity_ * i);
+    auto &used = used_[i];
+    const auto end = begin + used;
+    const auto it = std::find_if(begin, end, [j](const auto &neighbor) { return neighbor.point == j; });
+    if (add) {
+        if (it != end) {
+            ++it->count;
+            return false;
+        }
+        *end = {j, 1};
+        ++used;
+        return true;
+    }
+    if (--it->count > 0) {
+        return false;
+    }
+    // keeps the used neighbors contiguous.
+    *it = *(end - 1);
+    --used;
+    return true;
+}
+
+}  // namespace merge
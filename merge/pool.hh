@@ -0,0 +1,62 @@
+#pragma once
+
+// A pool of distinct local optima, the parents of multi-parent merges.
+// Tours are stored as their next arrays (one point id per point), which merges diff directly
+// against the current tour, so the pool needs no domain or metric of its own.
+// Edge frequencies are kept per point: a tour has two edges at each point,
+// so a point has at most 2 * capacity distinct pool edges.
+
+#include <primitives.hh>
+#include <tour.hh>
+
+#include <cstdint> // uint32_t, uint64_t
+#include <vector>
+
+namespace merge {
+
+class Pool {
+ public:
+    explicit Pool(size_t capacity) : capacity_(capacity) {}
+
+    // Adds tour unless the pool already has it. When full, tour replaces the oldest tour:
+    // keeping the shortest instead fills the pool with near copies of one optimum, which merge nothing new.
+    // Returns true if tour was added.
+    bool add(const Tour &tour);
+
+    size_t size() const { return next_.size(); }
+    size_t capacity() const { return capacity_; }
+    bool full() const { return size() >= capacity_; }
+    primitives::length_t length(size_t t) const { return lengths_[t]; }
+
+    // next point of each point in tour t of the pool.
+    const std::vector<primitives::point_id_t> &next(size_t t) const { return next_[t]; }
+
+    // number of tours in the pool with edge (i, j).
+    uint32_t frequency(primitives::point_id_t i, primitives::point_id_t j) const;
+    // number of distinct edges in the pool, and those in every tour of it.
+    size_t distinct_edges() const { return distinct_edges_; }
+    size_t common_edges() const;
+
+ private:
+    struct Neighbor {
+        primitives::point_id_t point;
+        uint32_t count;
+    };
+
+    const size_t capacity_;
+    std::vector<std::vector<primitives::point_id_t>> next_;
+    std::vector<primitives::length_t> lengths_;
+    std::vector<uint64_t> hashes_;
+    // the pool edges at point i are the first used_[i] of neighbors_[2 * capacity_ * i, 2 * capacity_ * (i + 1)).
+    std::vector<Neighbor> neighbors_;
+    std::vector<uint32_t> used_;
+    size_t distinct_edges_{0};
+    size_t oldest_{0};
+
+    bool contains(const Tour &tour) const;
+    void count_edges(size_t t, bool add);
+    // counts edge (i, j) in (or out of) the neighbors of i; returns true if the edge is new to, or gone from, the pool.
+    bool count_neighbor(primitives::point_id_t i, primitives::point_id_t j, bool add);
+};
+
+}  // namespace merge
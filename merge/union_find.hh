@@ -0,0 +1,44 @@
+#pragma once
+
+// Disjoint sets over [0, size), with union by size and path halving.
+
+#include <cstddef>
+#include <numeric> // iota
+#include <utility> // swap
+#include <vector>
+
+namespace merge {
+
+class UnionFind {
+ public:
+    explicit UnionFind(size_t size) : parent_(size), size_(size, 1) {
+        std::iota(std::begin(parent_), std::end(parent_), 0);
+    }
+
+    size_t find(size_t i) {
+        while (parent_[i] != i) {
+            parent_[i] = parent_[parent_[i]];
+            i = parent_[i];
+        }
+        return i;
+    }
+
+    void unite(size_t i, size_t j) {
+        i = find(i);
+        j = find(j);
+        if (i == j) {
+            return;
+        }
+        if (size_[i] < size_[j]) {
+            std::swap(i, j);
+        }
+        parent_[j] = i;
+        size_[i] += size_[j];
+    }
+
+ private:
+    std::vector<size_t> parent_;
+    std::vector<size_t> size_;
+};
+
+}  // namespace merge
@@ -0,0 +1,327 @@
+#pragma once
+
+// Distance metrics for the TSPLIB edge weight types (EDGE_WEIGHT_TYPE).
+// A metric is a policy passed as a template parameter (e.g. PointSet<metric::Att>),
+// so each distance call is an inlined, type-specific kernel with no per-call branch.
+// Every metric provides:
+//      length_t operator()(a, b): the TSPLIB (rounded) length of edge (a, b).
+//      void operator()(a, b, count, out): out[k] = length of edge (a, b[k]).
+//      Box box(i, radius): a box containing every point j with operator()(i, j) < radius.
+//      CHEAP_LENGTH: true if computing a length is about as fast as a cached table lookup.
+//      PLANAR: true if lengths never decrease with x-y distance, so nearest-first queries are also shortest-first.
+// Metrics hold pointers to coordinates (and small precomputed tables), so they are cheap to copy.
+
+#include "box.hh"
+#include "length_calculator.hh"
+#include "parallel.hh"
+#include "primitives.hh"
+
+#include <algorithm> // min
+#include <cmath>
+#include <cstddef> // size_t
+#include <cstdint> // uint32_t
+#include <limits>
+#include <memory> // shared_ptr
+#include <numeric> // iota
+#include <stdexcept>
+#include <vector>
+
+namespace metric {
+
+// square of half-width radius centered at (x, y).
+inline Box square(primitives::space_t x, primitives::space_t y, primitives::space_t radius) {
+    Box box;
+    box.xmin = x - radius;
+    box.xmax = x + radius;
+    box.ymin = y - radius;
+    box.ymax = y + radius;
+    return box;
+}
+
+// EUC_2D: nint of the Euclidean distance.
+class Euc2d {
+ public:
+    static constexpr bool CHEAP_LENGTH{true};
+    static constexpr bool PLANAR{true};
+
+    Euc2d(const std::vector<primitives::space_t> &x, const std::vector<primitives::space_t> &y)
+        : calculator_(x, y) {}
+
+    primitives::length_t operator()(primitives::point_id_t a, primitives::point_id_t b) const {
+        return calculator_(a, b);
+    }
+    void operator()(primitives::point_id_t a, const primitives::point_id_t *b, size_t count, primitives::length_t *out) const {
+        calculator_(a, b, count, out);
+    }
+    // nint(d) < radius implies d < radius.
+    Box box(primitives::point_id_t i, primitives::length_t radius) const {
+        return square(calculator_.x(i), calculator_.y(i), radius);
+    }
+
+ private:
+    LengthCalculator calculator_;
+};
+
+// CEIL_2D: Euclidean distance rounded up.
+class Ceil2d {
+ public:
+    static constexpr bool CHEAP_LENGTH{true};
+    static constexpr bool PLANAR{true};
+
+    Ceil2d(const std::vector<primitives::space_t> &x, const std::vector<primitives::space_t> &y)
+        : x_(&x), y_(&y) {}
+
+    primitives::length_t operator()(primitives::point_id_t a, primitives::point_id_t b) const {
+        const auto dx = (*x_)[a] - (*x_)[b];
+        const auto dy = (*y_)[a] - (*y_)[b];
+        const auto d = std::sqrt(dx * dx + dy * dy);
+        const primitives::length_t t = d; // truncated.
+        return (t < d) ? t + 1 : t;
+    }
+    void operator()(primitives::point_id_t a, const primitives::point_id_t *b, size_t count, primitives::length_t *out) const {
+        for (size_t k{0}; k < count; ++k) {
+            out[k] = operator()(a, b[k]);
+        }
+    }
+    // ceil(d) < radius implies d < radius.
+    Box box(primitives::point_id_t i, primitives::length_t radius) const {
+        return square((*x_)[i], (*y_)[i], radius);
+    }
+
+ private:
+    const std::vector<primitives::space_t> *x_{nullptr};
+    const std::vector<primitives::space_t> *y_{nullptr};
+};
+
+// ATT: pseudo-Euclidean distance, sqrt((dx^2 + dy^2) / 10) rounded up (the TSPLIB formulation).
+class Att {
+ public:
+    static constexpr bool CHEAP_LENGTH{true};
+    static constexpr bool PLANAR{true};
+
+    Att(const std::vector<primitives::space_t> &x, const std::vector<primitives::space_t> &y)
+        : x_(&x), y_(&y) {}
+
+    primitives::length_t operator()(primitives::point_id_t a, primitives::point_id_t b) const {
+        const auto dx = (*x_)[a] - (*x_)[b];
+        const auto dy = (*y_)[a] - (*y_)[b];
+        const auto r = std::sqrt((dx * dx + dy * dy) / 10.0);
+        const primitives::length_t t = r + 0.5;
+        return (t < r) ? t + 1 : t;
+    }
+    void operator()(primitives::point_id_t a, const primitives::point_id_t *b, size_t count, primitives::length_t *out) const {
+        for (size_t k{0}; k < count; ++k) {
+            out[k] = operator()(a, b[k]);
+        }
+    }
+    // the rounded length is at least d / sqrt(10), so length < radius implies d < radius * sqrt(10).
+    Box box(primitives::point_id_t i, primitives::length_t radius) const {
+        return square((*x_)[i], (*y_)[i], radius * std::sqrt(10.0));
+    }
+
+ private:
+    const std::vector<primitives::space_t> *x_{nullptr};
+    const std::vector<primitives::space_t> *y_{nullptr};
+};
+
+// GEO: great circle distance (km) on the TSPLIB idealized sphere.
+// x is latitude and y is longitude, both in DDD.MM (degrees, minutes) format.
+class Geo {
+ public:
+    static constexpr bool CHEAP_LENGTH{false}; // 3 cosines and an arc cosine.
+    static constexpr bool PLANAR{false};
+
+    Geo(const std::vector<primitives::space_t> &x, const std::vector<primitives::space_t> &y) {
+        auto radians = std::make_shared<std::vector<Radians>>(x.size());
+        for (primitives::point_id_t i{0}; i < x.size(); ++i) {
+            (*radians)[i] = {to_radians(x[i]), to_radians(y[i])};
+        }
+        radians_ = radians;
+    }
+
+    primitives::length_t operator()(primitives::point_id_t a, primitives::point_id_t b) const {
+        const auto &ra = (*radians_)[a];
+        const auto &rb = (*radians_)[b];
+        const auto q1 = std::cos(ra.longitude - rb.longitude);
+        const auto q2 = std::cos(ra.latitude - rb.latitude);
+        const auto q3 = std::cos(ra.latitude + rb.latitude);
+        // rounding can push the cosine slightly past 1 for (near) coincident points.
+        const auto cosine = std::min(1.0, 0.5 * ((1.0 + q1) * q2 - (1.0 - q1) * q3));
+        return static_cast<primitives::length_t>(RRR * std::acos(cosine) + 1.0);
+    }
+    void operator()(primitives::point_id_t a, const primitives::point_id_t *b, size_t count, primitives::length_t *out) const {
+        for (size_t k{0}; k < count; ++k) {
+            out[k] = operator()(a, b[k]);
+        }
+    }
+    // length < radius implies the central angle is less than radius / RRR.
+    // This bounds the latitude difference directly and the longitude difference
+    // via the widest point of the small circle; near the poles or across the
+    // antimeridian the box spans all longitudes.
+    Box box(primitives::point_id_t i, primitives::length_t radius) const {
+        constexpr auto lowest = std::numeric_limits<primitives::space_t>::lowest();
+        constexpr auto highest = std::numeric_limits<primitives::space_t>::max();
+        constexpr double epsilon{1e-9};
+        const auto angle = radius / RRR;
+        const auto &r = (*radians_)[i];
+        Box box;
+        box.xmin = to_coordinate(r.latitude - angle - epsilon);
+        box.xmax = to_coordinate(r.latitude + angle + epsilon);
+        box.ymin = lowest;
+        box.ymax = highest;
+        const auto cos_latitude = std::cos(r.latitude);
+        if (angle >= PI / 2 or std::sin(angle) >= cos_latitude) {
+            return box;
+        }
+        const auto longitude_angle = std::asin(std::sin(angle) / cos_latitude) + epsilon;
+        if (std::abs(r.longitude) + longitude_angle >= PI) {
+            return box;
+        }
+        box.ymin = to_coordinate(r.longitude - longitude_angle);
+        box.ymax = to_coordinate(r.longitude + longitude_angle);
+        return box;
+    }
+
+ private:
+    static constexpr double PI{3.141592};
+    static constexpr double RRR{6378.388};
+    struct Radians {
+        double latitude{0};
+        double longitude{0};
+    };
+
+    std::shared_ptr<const std::vector<Radians>> radians_;
+
+    static double to_radians(primitives::space_t coordinate) {
+        const auto degrees = std::trunc(coordinate);
+        const auto minutes = coordinate - degrees;
+        return PI * (degrees + 5.0 * minutes / 3.0) / 180.0;
+    }
+    // inverse of to_radians, for minutes below 60.
+    static primitives::space_t to_coordinate(double radians) {
+        const auto decimal_degrees = radians * 180.0 / PI;
+        const auto degrees = std::trunc(decimal_degrees);
+        return degrees + 0.6 * (decimal_degrees - degrees);
+    }
+};
+
+// EUC_3D: nint of the 3D Euclidean distance. Spatial queries use the x-y projection.
+class Euc3d {
+ public:
+    static constexpr bool CHEAP_LENGTH{true};
+    static constexpr bool PLANAR{false}; // z adds to the projected distance.
+
+    Euc3d(const std::vector<primitives::space_t> &x
+        , const std::vector<primitives::space_t> &y
+        , const std::vector<primitives::space_t> &z)
+        : x_(&x), y_(&y), z_(&z) {}
+
+    primitives::length_t operator()(primitives::point_id_t a, primitives::point_id_t b) const {
+        const auto dx = (*x_)[a] - (*x_)[b];
+        const auto dy = (*y_)[a] - (*y_)[b];
+        const auto dz = (*z_)[a] - (*z_)[b];
+        return std::sqrt(dx * dx + dy * dy + dz * dz) + 0.5;
+    }
+    void operator()(primitives::point_id_t a, const primitives::point_id_t *b, size_t count, primitives::length_t *out) const {
+        for (size_t k{0}; k < count; ++k) {
+            out[k] = operator()(a, b[k]);
+        }
+    }
+    // the projected distance is at most the 3D distance.
+    Box box(primitives::point_id_t i, primitives::length_t radius) const {
+        return square((*x_)[i], (*y_)[i], radius);
+    }
+
+ private:
+    const std::vector<primitives::space_t> *x_{nullptr};
+    const std::vector<primitives::space_t> *y_{nullptr};
+    const std::vector<primitives::space_t> *z_{nullptr};
+};
+
+// Precomputed lengths of Base, stored as a triangular table of 32-bit lengths.
+// A lookup replaces the distance computation, which pays off while the table stays
+// in cache (small instances); the table takes 2 * n * (n - 1) bytes.
+template <typename Base>
+class Matrix {
+ public:
+    static constexpr bool CHEAP_LENGTH{true};
+    static constexpr bool PLANAR{Base::PLANAR};
+
+    // computes all lengths in parallel. Throws if a length does not fit in 32 bits.
+    explicit Matrix(const Base &base, primitives::point_id_t size) : base_(base) {
+        const size_t entries = row_offset(size);
+        auto table = std::make_shared<std::vector<uint32_t>>(entries);
+        std::vector<char> overflow(parallel::block_count(entries), false);
+        parallel::blocks(entries, [this, &table, &overflow](size_t block, size_t begin, size_t end) {
+            // the block may start and end within a row, so fill it row segment by row segment.
+            std::vector<primitives::point_id_t> columns;
+            std::vector<primitives::length_t> lengths;
+            auto row = row_of(begin);
+            while (begin < end) {
+                const auto row_start = row_offset(row);
+                const auto count = std::min(end, row_start + row) - begin;
+                columns.resize(count);
+                std::iota(std::begin(columns), std::end(columns), begin - row_start);
+                lengths.resize(count);
+                base_(row, columns.data(), count, lengths.data());
+                for (size_t c{0}; c < count; ++c) {
+                    if (lengths[c] > std::numeric_limits<uint32_t>::max()) {
+                        overflow[block] = true;
+                    }
+                    (*table)[begin + c] = lengths[c];
+                }
+                begin += count;
+                ++row;
+            }
+        });
+        if (std::find(std::cbegin(overflow), std::cend(overflow), true) != std::cend(overflow)) {
+            throw std::invalid_argument("distance matrix: length does not fit in 32 bits.");
+        }
+        table_ = table;
+        data_ = table->data();
+    }
+
+    // bytes needed for the table of an instance of size points.
+    static size_t bytes(primitives::point_id_t size) {
+        return row_offset(size) * sizeof(uint32_t);
+    }
+
+    primitives::length_t operator()(primitives::point_id_t a, primitives::point_id_t b) const {
+        const auto row = std::max(a, b);
+        const auto column = std::min(a, b);
+        return (a == b) ? 0 : data_[row_offset(row) + column];
+    }
+    void operator()(primitives::point_id_t a, const primitives::point_id_t *b, size_t count, primitives::length_t *out) const {
+        for (size_t k{0}; k < count; ++k) {
+            out[k] = operator()(a, b[k]);
+        }
+    }
+    Box box(primitives::point_id_t i, primitives::length_t radius) const {
+        return base_.box(i, radius);
+    }
+
+    const Base &base() const { return base_; }
+
+ private:
+    Base base_;
+    // lengths (i, j) with i < j are at row_offset(j) + i.
+    std::shared_ptr<const std::vector<uint32_t>> table_;
+    const uint32_t *data_{nullptr}; // table_->data(), saving an indirection per lookup.
+
+    static size_t row_offset(size_t row) {
+        return row * (row - 1) / 2;
+    }
+    // the row containing table entry e.
+    static size_t row_of(size_t e) {
+        auto row = static_cast<size_t>((1 + std::sqrt(1 + 8.0 * e)) / 2);
+        while (row > 0 and row_offset(row) > e) {
+            --row;
+        }
+        while (row_offset(row + 1) <= e) {
+            ++row;
+        }
+        return row;
+    }
+};
+
+}  // namespace metric
@@ -33,12 +33,13 @@ size_t MulticycleTour::update_next(const primitives::point_id_t start
     , const primitives::cycle_id_t cycle_id) {
     primitives::point_id_t current{start};
     next_[current] = adjacents_[current].front();
+    next_length_[current] = adjacent_lengths_[current].front();
     primitives::point_id_t sequence {0};
     do {
         auto prev = current;
         sequence_[current] = sequence++;
         current = next_[current];
-        next_[current] = get_other(current, prev);
+        set_next(current, prev);
         cycle_id_[current] = cycle_id;
         if (sequence > size()) {
             std::cout << __func__ << ": error: sequence is higher than total number of points." << std::endl;
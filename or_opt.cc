@@ -0,0 +1,175 @@
+#include "or_opt.hh"
+
+#include <algorithm> // find
+#include <array>
+
+template <typename Metric>
+std::vector<primitives::point_id_t> OrOpt<Metric>::optimize(Tour &tour
+    , const std::vector<primitives::point_id_t> &points) {
+    const auto n = tour.size();
+    changed_points_.clear();
+    // segments need room to move without touching themselves.
+    if (n < 2 * MAX_SEGMENT + 2) {
+        return changed_points_;
+    }
+    next_.resize(n);
+    prev_.resize(n);
+    for (primitives::point_id_t i{0}; i < n; ++i) {
+        next_[i] = tour.next(i);
+        prev_[next_[i]] = i;
+    }
+    queued_.assign(n, false);
+    changed_.assign(n, false);
+    neighbors_.resize(n);
+    for (auto p : points) {
+        push(p);
+    }
+    const auto moves = moves_;
+    while (not queue_.empty()) {
+        const auto p = queue_.front();
+        queue_.pop_front();
+        queued_[p] = false;
+        if (improve(p)) {
+            // p may start more improving segments.
+            push(p);
+        }
+    }
+    if (moves_ > moves) {
+        std::vector<primitives::point_id_t> order;
+        order.reserve(n);
+        primitives::point_id_t current{0};
+        do {
+            order.push_back(current);
+            current = next_[current];
+        } while (current != 0);
+        tour.reset(order);
+    }
+    return changed_points_;
+}
+
+template <typename Metric>
+bool OrOpt<Metric>::improve(primitives::point_id_t first) {
+    std::array<primitives::point_id_t, MAX_SEGMENT> segment;
+    const auto p = prev_[first];
+    auto last = first;
+    segment[0] = first;
+    for (size_t size{1}; size <= MAX_SEGMENT; ++size) {
+        if (size > 1) {
+            last = next_[last];
+            segment[size - 1] = last;
+        }
+        const auto n = next_[last];
+        const auto removed = length(p, first) + length(last, n);
+        const auto bridge = length(p, n);
+        if (removed <= bridge) {
+            continue;
+        }
+        const auto gain = removed - bridge;
+        if (insert_near(first, last, segment.data(), size, gain)
+            or (size > 1 and insert_near(last, first, segment.data(), size, gain))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The new edge (c, end) must be shorter than the removal gain, as in the LK gain criterion.
+template <typename Metric>
+bool OrOpt<Metric>::insert_near(primitives::point_id_t end
+    , primitives::point_id_t other
+    , const primitives::point_id_t *segment
+    , size_t size
+    , primitives::length_t removal_gain) {
+    const auto in_segment = [segment, size](primitives::point_id_t point) {
+        return std::find(segment, segment + size, point) != segment + size;
+    };
+    for (auto c : neighbors(end)) {
+        const auto attach = length(c, end);
+        // not break: neighbors are nearest by coordinates, which need not be nearest by metric (e.g. GEO).
+        if (attach >= removal_gain or in_segment(c)) {
+            continue;
+        }
+        for (auto d : {prev_[c], next_[c]}) {
+            if (in_segment(d)) {
+                continue;
+            }
+            // (removal gain - attach) + (length(c, d) - length(other, d)) > 0.
+            if (removal_gain + length(c, d) <= attach + length(other, d)) {
+                continue;
+            }
+            if (d == next_[c]) {
+                move(segment, size, c, d, end);
+            } else {
+                move(segment, size, d, c, other);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename Metric>
+void OrOpt<Metric>::move(const primitives::point_id_t *segment, size_t size
+    , primitives::point_id_t a, primitives::point_id_t b, primitives::point_id_t x) {
+    const auto p = prev_[segment[0]];
+    const auto n = next_[segment[size - 1]];
+    next_[p] = n;
+    prev_[n] = p;
+    // a, the segment starting from x, then b.
+    std::array<primitives::point_id_t, MAX_SEGMENT + 2> order;
+    order[0] = a;
+    const bool forward = x == segment[0];
+    for (size_t i{0}; i < size; ++i) {
+        order[i + 1] = forward ? segment[i] : segment[size - 1 - i];
+    }
+    order[size + 1] = b;
+    for (size_t i{0}; i < size + 1; ++i) {
+        next_[order[i]] = order[i + 1];
+        prev_[order[i + 1]] = order[i];
+    }
+    ++moves_;
+    for (auto point : {p, n, a, b, segment[0], segment[size - 1]}) {
+        mark_changed(point);
+        // segments through point start at most MAX_SEGMENT - 1 points before it.
+        for (size_t i{0}; i < MAX_SEGMENT; ++i) {
+            push(point);
+            point = prev_[point];
+        }
+    }
+}
+
+template <typename Metric>
+const std::vector<primitives::point_id_t> &OrOpt<Metric>::neighbors(primitives::point_id_t point) {
+    auto &neighbors = neighbors_[point];
+    if (neighbors.empty()) {
+        neighbors = point_set_.knn(point, NEIGHBORS);
+    }
+    return neighbors;
+}
+
+template <typename Metric>
+void OrOpt<Metric>::push(primitives::point_id_t point) {
+    if (not queued_[point]) {
+        queued_[point] = true;
+        queue_.push_back(point);
+    }
+}
+
+template <typename Metric>
+void OrOpt<Metric>::mark_changed(primitives::point_id_t point) {
+    if (not changed_[point]) {
+        changed_[point] = true;
+        changed_points_.push_back(point);
+    }
+}
+
+template class OrOpt<metric::Euc2d>;
+template class OrOpt<metric::Ceil2d>;
+template class OrOpt<metric::Att>;
+template class OrOpt<metric::Geo>;
+template class OrOpt<metric::Euc3d>;
+template class OrOpt<metric::Matrix<metric::Euc2d>>;
+template class OrOpt<metric::Matrix<metric::Ceil2d>>;
+template class OrOpt<metric::Matrix<metric::Att>>;
+template class OrOpt<metric::Matrix<metric::Geo>>;
+template class OrOpt<metric::Matrix<metric::Euc3d>>;
@@ -0,0 +1,61 @@
+#pragma once
+
+// Or-opt: moves a segment of 1 to MAX_SEGMENT consecutive points to between two adjacent points elsewhere,
+// in either orientation. These are the cheap defects of fresh tours; the general k-opt search only reaches them at k = 3.
+// The tour is copied into a doubly linked list, so evaluating and applying a move are O(1);
+// the Tour is rebuilt once at the end.
+
+#include "point_set.hh"
+#include "primitives.hh"
+#include "tour.hh"
+
+#include <deque>
+#include <vector>
+
+// Metric is one of the policies in metric.hh; or_opt.cc instantiates all of them.
+template <typename Metric>
+class OrOpt {
+ public:
+    explicit OrOpt(const PointSet<Metric> &point_set) : point_set_(point_set) {}
+
+    // Applies improving moves until none is found from a queue of points, which starts with points.
+    // Returns the points whose tour neighbors changed.
+    std::vector<primitives::point_id_t> optimize(Tour &tour, const std::vector<primitives::point_id_t> &points);
+
+    size_t moves() const { return moves_; }
+
+ private:
+    static constexpr size_t MAX_SEGMENT{3};
+    // segments are only moved next to one of the NEIGHBORS nearest points of one of their ends.
+    static constexpr size_t NEIGHBORS{10};
+
+    const PointSet<Metric> &point_set_;
+    std::vector<primitives::point_id_t> next_;
+    std::vector<primitives::point_id_t> prev_;
+    std::deque<primitives::point_id_t> queue_;
+    std::vector<char> queued_;
+    std::vector<char> changed_;
+    std::vector<primitives::point_id_t> changed_points_;
+    // nearest points, nearest first; fetched when first needed.
+    std::vector<std::vector<primitives::point_id_t>> neighbors_;
+    size_t moves_{0};
+
+    // tries segments that start at first (in next_ order); true if one was moved.
+    bool improve(primitives::point_id_t first);
+    // tries inserting the segment with end attached to a point near it; other is the segment's other end.
+    bool insert_near(primitives::point_id_t end
+        , primitives::point_id_t other
+        , const primitives::point_id_t *segment
+        , size_t size
+        , primitives::length_t removal_gain);
+    // moves the segment (in next_ order) to between a and b = next_[a], with x next to a.
+    void move(const primitives::point_id_t *segment, size_t size
+        , primitives::point_id_t a, primitives::point_id_t b, primitives::point_id_t x);
+
+    const std::vector<primitives::point_id_t> &neighbors(primitives::point_id_t point);
+    void push(primitives::point_id_t point);
+    void mark_changed(primitives::point_id_t point);
+    primitives::length_t length(primitives::point_id_t a, primitives::point_id_t b) const {
+        return point_set_.length(a, b);
+    }
+};
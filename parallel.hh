@@ -0,0 +1,45 @@
+#pragma once
+
+// Minimal helpers for splitting index ranges across threads.
+
+#include <algorithm> // max, min
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+// most threads that helpers started from the calling thread may use; 0 is no limit.
+// Threads that already share the cores with others (e.g. search islands) set their share.
+inline thread_local size_t thread_limit{0};
+
+inline size_t thread_count() {
+    const size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    return thread_limit == 0 ? hardware : std::min(hardware, thread_limit);
+}
+
+// Splits [0, size) into contiguous blocks, one per thread,
+// and calls function(block, begin, end) for each block concurrently.
+// Blocks are numbered [0, block count) so that callers can keep per-block buffers.
+template <typename Function>
+void blocks(size_t size, const Function &function, size_t threads = thread_count()) {
+    threads = std::max<size_t>(1, std::min(threads, size));
+    const size_t block_size = (size + threads - 1) / threads;
+    std::vector<std::thread> workers;
+    for (size_t block{1}; block < threads; ++block) {
+        const size_t begin = std::min(size, block * block_size);
+        const size_t end = std::min(size, begin + block_size);
+        workers.emplace_back([&function, block, begin, end]() { function(block, begin, end); });
+    }
+    function(0, 0, std::min(size, block_size));
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+// Number of blocks that blocks() will use for a range of the given size.
+inline size_t block_count(size_t size, size_t threads = thread_count()) {
+    return std::max<size_t>(1, std::min(threads, size));
+}
+
+}  // namespace parallel
@@ -17,14 +17,16 @@
 
 namespace perturb {
 
-inline Tour perturb(const PointSet &point_set, const Tour &tour, size_t kmax) {
+template <typename Metric>
+Tour perturb(const PointSet<Metric> &point_set, const Tour &tour, size_t kmax) {
     auto new_tour = tour;
     randomize::double_bridge::swap(new_tour);
     hill_climb::hill_climb(point_set, new_tour, kmax);
     return new_tour;
 }
 
-inline Tour perturb(const HillClimber &hill_climber, const Tour &tour, size_t kmax) {
+template <typename Metric>
+Tour perturb(const HillClimber<Metric> &hill_climber, const Tour &tour, size_t kmax) {
     auto new_hill_climber = hill_climber;
     auto new_tour = tour;
     const auto kmove = randomize::double_bridge::swap(new_tour);
@@ -50,7 +52,8 @@ inline KMove dense_kswap(const std::vector<primitives::point_id_t> &ordered_poin
     }
     return kmove;
 }
-inline Tour dense_kswap(const HillClimber &hill_climber, const Tour &tour, size_t kmax, size_t swap_kmax) {
+template <typename Metric>
+Tour dense_kswap(const HillClimber<Metric> &hill_climber, const Tour &tour, size_t kmax, size_t swap_kmax) {
     auto new_hill_climber = hill_climber;
     auto new_tour = tour;
     const auto kmove = dense_kswap(new_tour.order(), randomize::sequence(new_tour.size()), swap_kmax);
@@ -80,7 +83,8 @@ inline KMove kswap(const std::vector<primitives::point_id_t> &ordered_points, si
     }
     return kmove;
 }
-inline Tour kswap(const HillClimber &hill_climber, const Tour &tour, size_t kmax, size_t swap_kmax) {
+template <typename Metric>
+Tour kswap(const HillClimber<Metric> &hill_climber, const Tour &tour, size_t kmax, size_t swap_kmax) {
     auto new_hill_climber = hill_climber;
     auto new_tour = tour;
     const auto kmove = kswap(new_tour.order(), randomize::sequence(new_tour.size()), swap_kmax);
@@ -90,17 +94,18 @@ inline Tour kswap(const HillClimber &hill_climber, const Tour &tour, size_t kmax
     return new_tour;
 }
 
-inline Tour random_restart(const PointSet &point_set, const point_quadtree::Domain *domain, size_t kmax) {
-    HillClimber hill_climber(point_set);
+template <typename Metric>
+Tour random_restart(const PointSet<Metric> &point_set, const point_quadtree::Domain *domain, size_t kmax) {
+    HillClimber<Metric> hill_climber(point_set);
     const auto &n = domain->x().size();
     std::vector<primitives::point_id_t> random_order(n);
     for (primitives::point_id_t i{0}; i < n; ++i) {
         random_order[i] = i;
     }
-    static std::random_device device; // will be used to obtain a seed for the random number engine
-    static std::mt19937 generator(device()); // standard mersenne_twister_engine seeded with random_device.
+    thread_local std::random_device device; // will be used to obtain a seed for the random number engine
+    thread_local std::mt19937 generator(device()); // standard mersenne_twister_engine seeded with random_device.
     std::shuffle(std::begin(random_order), std::end(random_order), generator);
-    Tour tour(domain, random_order);
+    Tour tour(domain, random_order, point_set.metric());
     hill_climb::hill_climb(hill_climber, tour, kmax);
     return tour;
 }
@@ -116,8 +121,8 @@ inline KMove random_section(const std::vector<primitives::point_id_t> &ordered_p
     }
     // first and last point in randomized sequence will not be shuffled,
     // but connected edges will still be deleted.
-    static std::random_device device; // will be used to obtain a seed for the random number engine
-    static std::mt19937 generator(device()); // standard mersenne_twister_engine seeded with random_device.
+    thread_local std::random_device device; // will be used to obtain a seed for the random number engine
+    thread_local std::mt19937 generator(device()); // standard mersenne_twister_engine seeded with random_device.
     std::shuffle(std::next(std::begin(random_order)), std::prev(std::end(random_order)), generator);
 
     KMove kmove;
@@ -131,7 +136,8 @@ inline KMove random_section(const std::vector<primitives::point_id_t> &ordered_p
     return kmove;
 }
 
-inline Tour random_section(const HillClimber &hill_climber, const Tour &tour, size_t kmax, double random_fraction) {
+template <typename Metric>
+Tour random_section(const HillClimber<Metric> &hill_climber, const Tour &tour, size_t kmax, double random_fraction) {
     auto new_hill_climber = hill_climber;
     auto new_tour = tour;
     const auto kmove = random_section(new_tour.order(), randomize::sequence(new_tour.size()), random_fraction);
@@ -147,8 +153,8 @@ inline std::vector<primitives::point_id_t> one_edge_per_cycle(const MulticycleTo
     for (auto &p : points) {
         p = i++;
     }
-    static std::random_device device; // will be used to obtain a seed for the random number engine
-    static std::mt19937 generator(device()); // standard mersenne_twister_engine seeded with random_device.
+    thread_local std::random_device device; // will be used to obtain a seed for the random number engine
+    thread_local std::mt19937 generator(device()); // standard mersenne_twister_engine seeded with random_device.
     std::shuffle(std::begin(points), std::end(points), generator);
     std::vector<primitives::point_id_t> selections(tour.cycles(), constants::INVALID_POINT);
     size_t selected{0};
@@ -4,7 +4,9 @@
 #include <constants.h>
 
 #include <array>
-#include <algorithm> // min_element, max_element
+#include <algorithm> // min_element, max_element, sort
+#include <cmath> // ldexp
+#include <optional>
 #include <vector>
 #include <ostream>
 
@@ -34,18 +36,20 @@ public:
         m_ymin -= RootNodeMargin * yrange;
         xrange *= 1 + 2 * RootNodeMargin;
         yrange *= 1 + 2 * RootNodeMargin;
-        primitives::grid_t grid_dim {1};
         for (primitives::depth_t depth {0}; depth < constants::max_tree_depth; ++depth)
         {
-            m_xdim[depth] = xrange / static_cast<primitives::space_t>(grid_dim);
-            m_ydim[depth] = yrange / static_cast<primitives::space_t>(grid_dim);
-            grid_dim <<= 1;
+            m_xdim[depth] = std::ldexp(xrange, -depth);
+            m_ydim[depth] = std::ldexp(yrange, -depth);
         }
+        m_max_depth = std::max(leaf_depth(x, m_xdim), leaf_depth(y, m_ydim));
     }
     auto xmin() const { return m_xmin; }
     auto ymin() const { return m_ymin; }
     auto xdim(int depth) const { return m_xdim[depth]; }
     auto ydim(int depth) const { return m_ydim[depth]; }
+    // Depth at which quadtree nodes are narrower than the smallest nonzero coordinate gap,
+    // so that only coincident points can share a leaf (up to the Morton key resolution).
+    auto max_depth() const { return m_max_depth; }
 
     const auto& x() const { return m_x; }
     const auto& y() const { return m_y; }
@@ -58,6 +62,32 @@ private:
     primitives::space_t m_ymin {0};
     std::array<primitives::space_t, constants::max_tree_depth> m_xdim; // x-dimension of boxes.
     std::array<primitives::space_t, constants::max_tree_depth> m_ydim; // y-dimension of boxes.
+    primitives::depth_t m_max_depth {constants::max_tree_depth - 1};
+
+    static primitives::depth_t leaf_depth(std::vector<primitives::space_t> coordinates
+        , const std::array<primitives::space_t, constants::max_tree_depth>& dim)
+    {
+        std::sort(std::begin(coordinates), std::end(coordinates));
+        std::optional<primitives::space_t> min_gap;
+        for (size_t i {1}; i < coordinates.size(); ++i)
+        {
+            const auto gap {coordinates[i] - coordinates[i - 1]};
+            if (gap > 0 and (not min_gap or gap < *min_gap))
+            {
+                min_gap = gap;
+            }
+        }
+        if (not min_gap)
+        {
+            return 0; // all coordinates are the same.
+        }
+        primitives::depth_t depth {0};
+        while (depth < constants::max_tree_depth - 1 and not (dim[depth] < *min_gap))
+        {
+            ++depth;
+        }
+        return depth;
+    }
 };
 
 } // namespace point_quadtree
@@ -32,6 +32,7 @@ public:
 
     auto x() const { return m_x; }
     auto y() const { return m_y; }
+    const auto& domain() const { return *m_domain; }
 
 private:
     const Domain* m_domain {nullptr};
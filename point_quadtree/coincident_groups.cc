@@ -0,0 +1,97 @@
+#include "coincident_groups.hh"
+
+#include <constants.h>
+
+#include <algorithm> // stable_sort
+#include <limits>
+#include <numeric> // iota
+
+namespace point_quadtree {
+
+CoincidentGroups::CoincidentGroups(const std::vector<primitives::space_t> &x
+    , const std::vector<primitives::space_t> &y
+    , const std::vector<primitives::space_t> &z
+    , size_t max_members)
+    : representatives_(x.size())
+    , previous_(x.size(), constants::invalid_point)
+    , next_(x.size(), constants::invalid_point)
+    , ranks_(x.size(), 0)
+    , max_members_(max_members == 0 ? x.size() : max_members) {
+    const auto same = [&x, &y, &z](auto a, auto b) {
+        return x[a] == x[b] and y[a] == y[b] and (z.empty() or z[a] == z[b]);
+    };
+    std::vector<primitives::point_id_t> order(x.size());
+    std::iota(std::begin(order), std::end(order), 0);
+    // stable, so each group is in index order and starts with its representative.
+    std::stable_sort(std::begin(order), std::end(order), [&x, &y, &z](auto a, auto b) {
+        if (x[a] != x[b]) {
+            return x[a] < x[b];
+        }
+        if (y[a] != y[b] or z.empty()) {
+            return y[a] < y[b];
+        }
+        return z[a] < z[b];
+    });
+    for (size_t k{0}; k < order.size(); ++k) {
+        const auto i = order[k];
+        if (k == 0 or not same(i, order[k - 1])) {
+            representatives_[i] = i;
+            continue;
+        }
+        const auto previous = order[k - 1];
+        representatives_[i] = representatives_[previous];
+        previous_[i] = previous;
+        next_[previous] = i;
+        ranks_[i] = ranks_[previous] + 1;
+        ++duplicates_;
+    }
+}
+
+void CoincidentGroups::expand(primitives::point_id_t i, std::vector<primitives::point_id_t> &points) const {
+    if (duplicates_ == 0) {
+        return;
+    }
+    constexpr auto ALL{std::numeric_limits<size_t>::max()};
+    const auto representatives = points.size();
+    for (size_t r{0}; r < representatives; ++r) {
+        append_members(next_[points[r]], constants::invalid_point, points, ALL);
+    }
+    append_chain(i, points, ALL);
+}
+
+std::vector<primitives::point_id_t> CoincidentGroups::nearest(primitives::point_id_t i
+    , const std::vector<primitives::point_id_t> &representatives
+    , size_t k) const {
+    std::vector<primitives::point_id_t> nearest;
+    nearest.reserve(k);
+    const auto own = representatives_[i];
+    append_members(own, i, nearest, k);
+    append_chain(i, nearest, k);
+    for (auto r : representatives) {
+        if (r != own) {
+            append_members(r, constants::invalid_point, nearest, k);
+        }
+    }
+    return nearest;
+}
+
+void CoincidentGroups::append_members(primitives::point_id_t first
+    , primitives::point_id_t skip
+    , std::vector<primitives::point_id_t> &points
+    , size_t k) const {
+    for (auto p = first; p != constants::invalid_point and ranks_[p] < max_members_ and points.size() < k; p = next_[p]) {
+        if (p != skip) {
+            points.push_back(p);
+        }
+    }
+}
+
+void CoincidentGroups::append_chain(primitives::point_id_t i, std::vector<primitives::point_id_t> &points, size_t k) const {
+    for (auto p : {previous_[i], next_[i]}) {
+        if (p != constants::invalid_point and ranks_[p] >= max_members_ and points.size() < k) {
+            points.push_back(p);
+        }
+    }
+}
+
+}  // namespace point_quadtree
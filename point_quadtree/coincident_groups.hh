@@ -0,0 +1,62 @@
+#pragma once
+
+// Points with identical coordinates, grouped so that spatial indexes hold one entry per location.
+// Each group is represented by its lowest-index member, and its members are chained in index order.
+// Queries expand each representative they find into the first members of its group, and add the chain
+// neighbors of the query point in its own group, so every member stays reachable through zero-length edges.
+// Without a limit on the members, queries return the same points as an index of every point.
+
+#include <primitives.hh>
+
+#include <cstddef> // size_t
+#include <vector>
+
+namespace point_quadtree {
+
+class CoincidentGroups {
+ public:
+    // z is empty for planar instances. max_members: most members of a group returned for its representative;
+    // 0 returns all of them.
+    CoincidentGroups(const std::vector<primitives::space_t> &x
+        , const std::vector<primitives::space_t> &y
+        , const std::vector<primitives::space_t> &z
+        , size_t max_members = 0);
+
+    primitives::point_id_t representative(primitives::point_id_t i) const { return representatives_[i]; }
+    bool representative_of_itself(primitives::point_id_t i) const { return representatives_[i] == i; }
+    // members before and after i in its group's chain; constants::invalid_point at either end.
+    primitives::point_id_t previous(primitives::point_id_t i) const { return previous_[i]; }
+    primitives::point_id_t next(primitives::point_id_t i) const { return next_[i]; }
+
+    // expands the representatives in points (found by a query from i that includes i's location)
+    // into the first members of their groups, and adds the chain neighbors of i.
+    void expand(primitives::point_id_t i, std::vector<primitives::point_id_t> &points) const;
+    // up to k nearest points to i (excluding i), nearest first, from representatives: the nearest other locations,
+    // nearest first, possibly including i's own. i's group comes first, then each other group in order.
+    std::vector<primitives::point_id_t> nearest(primitives::point_id_t i
+        , const std::vector<primitives::point_id_t> &representatives
+        , size_t k) const;
+
+    // points that are not the representative of their group.
+    size_t duplicates() const { return duplicates_; }
+
+ private:
+    std::vector<primitives::point_id_t> representatives_;
+    std::vector<primitives::point_id_t> previous_;
+    std::vector<primitives::point_id_t> next_;
+    // position of each point in its group's chain.
+    std::vector<primitives::point_id_t> ranks_;
+    const size_t max_members_;
+    size_t duplicates_{0};
+
+    // while points has fewer than k: appends first and the members after it among the first max_members_
+    // of its group, except skip.
+    void append_members(primitives::point_id_t first
+        , primitives::point_id_t skip
+        , std::vector<primitives::point_id_t> &points
+        , size_t k) const;
+    // while points has fewer than k: appends the chain neighbors of i that are not among the first max_members_.
+    void append_chain(primitives::point_id_t i, std::vector<primitives::point_id_t> &points, size_t k) const;
+};
+
+}  // namespace point_quadtree
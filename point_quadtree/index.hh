@@ -0,0 +1,47 @@
+#pragma once
+
+// SpatialIndex backed by the point quadtree.
+// The tree holds one representative per location, which queries expand into its coincident group,
+// so a large group costs the tree no more than one point.
+
+#include "coincident_groups.hh"
+#include "nearest.hh"
+#include "node.hh"
+#include <spatial_index.hh>
+
+#include <utility> // move
+#include <vector>
+
+namespace point_quadtree {
+
+class Index : public SpatialIndex {
+ public:
+    Index(Node root
+        , const std::vector<primitives::space_t> &x
+        , const std::vector<primitives::space_t> &y
+        , CoincidentGroups groups)
+        : root_(std::move(root)), x_(x), y_(y), groups_(std::move(groups)) {}
+
+    std::vector<primitives::point_id_t> get_points(primitives::point_id_t i, const Box &box) const override {
+        auto points = root_.get_points(i, box);
+        groups_.expand(i, points);
+        return points;
+    }
+
+    using SpatialIndex::knn;
+    std::vector<primitives::point_id_t> knn(primitives::point_id_t i, size_t k) const override {
+        return point_quadtree::knn(root_, x_, y_, groups_, i, k);
+    }
+
+    primitives::point_id_t size() const override { return x_.size(); }
+
+    const Node &root() const { return root_; }
+
+ private:
+    const Node root_;
+    const std::vector<primitives::space_t> &x_;
+    const std::vector<primitives::space_t> &y_;
+    const CoincidentGroups groups_;
+};
+
+}  // namespace point_quadtree
@@ -0,0 +1,75 @@
+#include "nearest.hh"
+
+#include <algorithm> // max
+
+namespace point_quadtree {
+
+NeighborIterator::NeighborIterator(const Node &root
+    , const std::vector<primitives::space_t> &x
+    , const std::vector<primitives::space_t> &y
+    , primitives::point_id_t i)
+    : x_(x), y_(y), i_(i) {
+    queue_.push({distance2(root.box()), &root, 0});
+}
+
+std::optional<primitives::point_id_t> NeighborIterator::next() {
+    while (not queue_.empty()) {
+        const auto top = queue_.top();
+        queue_.pop();
+        if (top.node) {
+            expand(*top.node);
+            continue;
+        }
+        if (top.point != i_) {
+            return top.point;
+        }
+    }
+    return std::nullopt;
+}
+
+void NeighborIterator::expand(const Node &node) {
+    for (const auto p : node.points()) {
+        queue_.push({distance2(p), nullptr, p});
+    }
+    for (const auto &child : node.children()) {
+        if (child) {
+            queue_.push({distance2(child->box()), child.get(), 0});
+        }
+    }
+}
+
+primitives::space_t NeighborIterator::distance2(const Box &box) const {
+    const auto x = x_[i_];
+    const auto y = y_[i_];
+    const primitives::space_t dx = std::max({box.xmin - x, x - box.xmax, primitives::space_t{0}});
+    const primitives::space_t dy = std::max({box.ymin - y, y - box.ymax, primitives::space_t{0}});
+    return dx * dx + dy * dy;
+}
+
+primitives::space_t NeighborIterator::distance2(primitives::point_id_t j) const {
+    const auto dx = x_[i_] - x_[j];
+    const auto dy = y_[i_] - y_[j];
+    return dx * dx + dy * dy;
+}
+
+std::vector<primitives::point_id_t> knn(const Node &root
+    , const std::vector<primitives::space_t> &x
+    , const std::vector<primitives::space_t> &y
+    , const CoincidentGroups &groups
+    , primitives::point_id_t i
+    , size_t k) {
+    // k locations other than i's hold at least k points; i's own may come out of the tree too.
+    std::vector<primitives::point_id_t> representatives;
+    representatives.reserve(k + 1);
+    NeighborIterator it(root, x, y, i);
+    while (representatives.size() <= k) {
+        const auto p = it.next();
+        if (not p) {
+            break;
+        }
+        representatives.push_back(*p);
+    }
+    return groups.nearest(i, representatives, k);
+}
+
+}  // namespace point_quadtree
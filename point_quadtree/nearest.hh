@@ -0,0 +1,58 @@
+#pragma once
+
+// Distance-ordered queries on the point quadtree.
+// Nodes and points are visited best-first with a priority queue keyed on
+// (squared) Euclidean distance, so points come out in order of increasing distance.
+
+#include "coincident_groups.hh"
+#include "node.hh"
+#include <box.hh>
+#include <primitives.hh>
+
+#include <optional>
+#include <queue>
+#include <vector>
+
+namespace point_quadtree {
+
+// Lazily visits all points other than i, nearest first.
+class NeighborIterator {
+ public:
+    NeighborIterator(const Node &root
+        , const std::vector<primitives::space_t> &x
+        , const std::vector<primitives::space_t> &y
+        , primitives::point_id_t i);
+
+    // Returns the next nearest point, or std::nullopt once all points have been visited.
+    std::optional<primitives::point_id_t> next();
+
+ private:
+    struct Entry {
+        primitives::space_t distance2{0}; // squared distance to query point (lower bound for nodes).
+        const Node *node{nullptr}; // nullptr for point entries.
+        primitives::point_id_t point{0};
+    };
+    struct Farther {
+        bool operator()(const Entry &lhs, const Entry &rhs) const { return lhs.distance2 > rhs.distance2; }
+    };
+
+    const std::vector<primitives::space_t> &x_;
+    const std::vector<primitives::space_t> &y_;
+    const primitives::point_id_t i_;
+    std::priority_queue<Entry, std::vector<Entry>, Farther> queue_;
+
+    primitives::space_t distance2(const Box &box) const;
+    primitives::space_t distance2(primitives::point_id_t j) const;
+    void expand(const Node &node);
+};
+
+// Returns up to k nearest points to i (excluding i), nearest first,
+// expanding the representatives in the tree into their coincident groups.
+std::vector<primitives::point_id_t> knn(const Node &root
+    , const std::vector<primitives::space_t> &x
+    , const std::vector<primitives::space_t> &y
+    , const CoincidentGroups &groups
+    , primitives::point_id_t i
+    , size_t k);
+
+}  // namespace point_quadtree
@@ -33,6 +33,7 @@ public:
         (primitives::point_id_t i, const Box& search_box) const;
 
     const auto& box() const { return m_box; }
+    const auto& points() const { return m_points; }
     bool leaf() const;
     primitives::point_id_t pop();
 
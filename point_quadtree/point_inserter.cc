@@ -8,7 +8,7 @@ void PointInserter::place()
     {
         descend();
     }
-    if (m_current_node->empty() or m_current_depth == constants::max_tree_depth)
+    if (m_current_node->empty() or m_current_depth >= m_grid_position.domain().max_depth())
     {
         m_current_node->insert(m_point);
         return;
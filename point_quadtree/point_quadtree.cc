@@ -4,15 +4,17 @@ namespace point_quadtree {
 
 Node make_quadtree(const std::vector<primitives::space_t>& x
     , const std::vector<primitives::space_t>& y
-    , const Domain& domain)
+    , const Domain& domain
+    , const CoincidentGroups& groups)
 {
     GridPosition grid_position(domain);
     Node root(grid_position.make_box());
-    insert_points(x, y, domain, root);
-    validate(root);
+    insert_points(x, y, domain, groups, root);
+    validate(root, domain);
+    std::cout << "duplicate points: " << groups.duplicates() << std::endl;
     std::cout << "max node occupancy: " << max_leaf_points(root) << std::endl;
     std::cout << "max tree depth: " << max_depth(root) << std::endl;
-    if (count_points(root) != x.size())
+    if (count_points(root) != x.size() - groups.duplicates())
     {
         throw std::logic_error("quadtree root did not count points accurately.");
     }
@@ -22,6 +24,7 @@ Node make_quadtree(const std::vector<primitives::space_t>& x
 void insert_points(const std::vector<primitives::space_t>& x
     , const std::vector<primitives::space_t>& y
     , const Domain& domain
+    , const CoincidentGroups& groups
     , Node& root)
 {
     const auto morton_keys
@@ -31,11 +34,14 @@ void insert_points(const std::vector<primitives::space_t>& x
     GridPosition grid_position(domain);
     for (primitives::point_id_t i {0}; i < morton_keys.size(); ++i)
     {
-        PointInserter inserter(grid_position
-            , morton_keys
-            , i
-            , &root
-            , 0);
+        if (groups.representative_of_itself(i))
+        {
+            PointInserter inserter(grid_position
+                , morton_keys
+                , i
+                , &root
+                , 0);
+        }
     }
 }
 
@@ -69,7 +75,7 @@ size_t count_nodes(const Node& node)
     return counted;
 }
 
-void validate(const Node& node, primitives::depth_t depth)
+void validate(const Node& node, const Domain& domain, primitives::depth_t depth)
 {
     if (node.leaf() and node.empty())
     {
@@ -79,11 +85,16 @@ void validate(const Node& node, primitives::depth_t depth)
     {
         throw std::logic_error("non-leaf node is not empty!");
     }
-    if (depth != constants::max_tree_depth and node.size() > 1)
+    const auto& points {node.points()};
+    const auto coincident = [&domain, &points](auto i)
+    {
+        return domain.x()[i] == domain.x()[points[0]] and domain.y()[i] == domain.y()[points[0]];
+    };
+    if (depth != domain.max_depth() and not std::all_of(std::cbegin(points), std::cend(points), coincident))
     {
-        throw std::logic_error("found non-max-depth node with more than 1 point!");
+        throw std::logic_error("found non-max-depth node with more than 1 distinct point!");
     }
-    if (depth > constants::max_tree_depth)
+    if (depth > domain.max_depth())
     {
         throw std::logic_error("max tree depth exceeded!");
     }
@@ -91,7 +102,7 @@ void validate(const Node& node, primitives::depth_t depth)
     {
         if (unique_ptr)
         {
-            validate(*unique_ptr, depth + 1);
+            validate(*unique_ptr, domain, depth + 1);
         }
     }
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "coincident_groups.hh"
 #include "Domain.h"
 #include "GridPosition.h"
 #include "node.hh"
@@ -8,21 +9,27 @@
 #include <box.hh>
 #include <primitives.hh>
 
+#include <algorithm> // all_of
+#include <vector>
+
 namespace point_quadtree {
 
+// Only the representative of each group of coincident points is inserted.
 Node make_quadtree(const std::vector<primitives::space_t>& x
     , const std::vector<primitives::space_t>& y
-    , const Domain&);
+    , const Domain&
+    , const CoincidentGroups&);
 
 void insert_points(const std::vector<primitives::space_t>& x
     , const std::vector<primitives::space_t>& y
     , const Domain& domain
+    , const CoincidentGroups& groups
     , Node& root);
 
 size_t count_points(const Node& node);
 size_t count_nodes(const Node& node);
 
-void validate(const Node& node, primitives::depth_t depth = 0);
+void validate(const Node& node, const Domain& domain, primitives::depth_t depth = 0);
 
 size_t max_leaf_points(const Node& node);
 primitives::depth_t max_depth(const Node& node, primitives::depth_t depth = 0);
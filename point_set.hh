@@ -1,48 +1,61 @@
 #pragma once
 
 // Represents a TSP instance (not any particular tour, though).
+// Metric is one of the policies in metric.hh.
 
 #include <vector>
 
-#include "length_calculator.hh"
-#include "box_maker.hh"
+#include "metric.hh"
 #include "primitives.hh"
-#include "point_quadtree/node.hh"
+#include "spatial_index.hh"
 
+template <typename Metric>
 class PointSet {
  public:
-    PointSet(const point_quadtree::Node& root,
-        const std::vector<primitives::space_t> &x,
-        const std::vector<primitives::space_t> &y)
-        : m_root(root), m_box_maker(x, y), size_(x.size()), m_length_calculator(x, y) {}
+    PointSet(const SpatialIndex& index, const Metric &metric)
+        : m_index(index), size_(index.size()), m_metric(metric) {}
 
     primitives::length_t length(primitives::point_id_t a, primitives::point_id_t b) const {
-        return m_length_calculator(a, b);
+        return m_metric(a, b);
+    }
+    // out[k] = length(a, b[k]) for k in [0, count), vectorized when possible.
+    void length(primitives::point_id_t a, const primitives::point_id_t *b, size_t count, primitives::length_t *out) const {
+        m_metric(a, b, count, out);
     }
 
-    // Returns points within square (of size 2 * radius) centered at point i.
+    // Returns (at least) the points j with length(i, j) < radius.
     inline std::vector<primitives::point_id_t> get_points(primitives::point_id_t i,
         primitives::length_t radius) const {
-        return m_root.get_points(i, m_box_maker(i, radius));
+        return m_index.get_points(i, m_metric.box(i, radius));
     }
-    // Returns points within square (of size 2 * radius) centered at point i.
+    // Returns points within box. i is the query point.
     inline std::vector<primitives::point_id_t> get_points(primitives::point_id_t i, const Box &box) const {
-        return m_root.get_points(i, box);
+        return m_index.get_points(i, box);
+    }
+
+    // Returns up to k nearest points to i (excluding i), nearest first.
+    std::vector<primitives::point_id_t> knn(primitives::point_id_t i, size_t k) const {
+        return m_index.knn(i, k);
+    }
+    // Returns the k-nearest-neighbor lists of all points (e.g. fixed candidate sets), computed in parallel.
+    std::vector<std::vector<primitives::point_id_t>> knn(size_t k) const {
+        return m_index.knn(k);
     }
 
+    // Returns a box containing every point j with length(i, j) < radius.
     inline Box get_box(primitives::point_id_t i, primitives::length_t radius) const {
-        return m_box_maker(i, radius);
+        return m_metric.box(i, radius);
     }
 
     inline primitives::point_id_t size() const {
         return size_;
     }
 
+    const Metric &metric() const { return m_metric; }
+
  private:
-    const point_quadtree::Node& m_root;
-    const BoxMaker m_box_maker;
+    const SpatialIndex& m_index;
     const primitives::point_id_t size_{0};
-    LengthCalculator m_length_calculator;
+    Metric m_metric;
 
 };
-
@@ -8,8 +8,8 @@ namespace randomize {
 
 // random integer in [a, b].
 inline primitives::point_id_t random_point(primitives::sequence_t a, primitives::sequence_t b) {
-    static std::random_device device; // will be used to obtain a seed for the random number engine
-    static std::mt19937 generator(device()); // standard mersenne_twister_engine seeded with random_device.
+    thread_local std::random_device device; // will be used to obtain a seed for the random number engine
+    thread_local std::mt19937 generator(device()); // standard mersenne_twister_engine seeded with random_device.
     std::uniform_int_distribution<primitives::point_id_t> distribution(a, b);
     return distribution(generator);
 }
@@ -27,8 +27,8 @@ inline std::vector<primitives::sequence_t> random_set(primitives::sequence_t sta
         candidates[s] = s;
     }
     const auto &begin = std::begin(candidates);
-    static std::random_device device; // will be used to obtain a seed for the random number engine
-    static std::mt19937 generator(device()); // standard mersenne_twister_engine seeded with random_device.
+    thread_local std::random_device device; // will be used to obtain a seed for the random number engine
+    thread_local std::mt19937 generator(device()); // standard mersenne_twister_engine seeded with random_device.
     std::shuffle(begin, std::end(candidates), generator);
     std::vector<primitives::sequence_t> selection(begin, begin + k);
     std::sort(std::begin(selection), std::end(selection));
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "multi_box.hh"
+#include "point_set.hh"
 #include "primitives.hh"
+#include "tour.hh"
 
 #include <algorithm>
 #include <iostream>
@@ -9,7 +11,8 @@
 
 namespace research {
 
-inline std::vector<primitives::point_id_t> shorter_edge_opportunities(const PointSet &point_set, const Tour &tour) {
+template <typename Metric>
+std::vector<primitives::point_id_t> shorter_edge_opportunities(const PointSet<Metric> &point_set, const Tour &tour) {
     std::vector<size_t> shorter_edge_count;
     std::vector<primitives::point_id_t> points_with_shorter_edges;
     using Edge = std::pair<primitives::point_id_t, primitives::point_id_t>;
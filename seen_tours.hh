@@ -0,0 +1,36 @@
+#pragma once
+
+// Hashes (Tour::hash()) of the most recently seen tours, so that repeated local optima are recognized in O(1).
+
+#include <cstdint> // uint64_t
+#include <deque>
+#include <unordered_set>
+
+class SeenTours {
+ public:
+    explicit SeenTours(size_t capacity) : capacity_(capacity) {}
+
+    // Returns false if hash was seen recently. Otherwise remembers it, forgetting the oldest hash when full.
+    // With capacity 0 nothing is remembered, so every hash is new.
+    bool insert(uint64_t hash) {
+        if (capacity_ == 0) {
+            return true;
+        }
+        if (not hashes_.insert(hash).second) {
+            return false;
+        }
+        order_.push_back(hash);
+        if (order_.size() > capacity_) {
+            hashes_.erase(order_.front());
+            order_.pop_front();
+        }
+        return true;
+    }
+
+    size_t size() const { return order_.size(); }
+
+ private:
+    const size_t capacity_;
+    std::unordered_set<uint64_t> hashes_;
+    std::deque<uint64_t> order_; // oldest first.
+};
@@ -0,0 +1,187 @@
+#pragma once
+
+// Incremental view of a partial sequential move, as the hill climber builds it.
+// The deleted edges cut the tour into segments; each segment end is labeled by the deleted edge it belongs to:
+//  label 2 * e is the first point of the e-th deleted edge (i), label 2 * e + 1 is the second (next(i)).
+// A point shared by two deleted edges gets both labels, joined by a segment of a single point.
+// Whether the move closes into a single tour is then a walk over segments and new edges in O(k),
+// instead of relabeling all points from scratch (cycle_check::feasible).
+
+#include "primitives.hh"
+
+#include <stdexcept>
+#include <utility> // pair
+#include <vector>
+
+class SegmentTracker {
+ public:
+    using Label = size_t;
+
+    static Label label(size_t deleted_edge, bool second) {
+        return 2 * deleted_edge + second;
+    }
+
+    // sequence: position of the deleted edge's first point in the tour, from any fixed origin.
+    // Edges are only recorded here; the segment order is brought up to date by the first query that needs it,
+    // as most partial moves are extended or abandoned without asking.
+    void delete_edge(primitives::sequence_t sequence) {
+        sequences_.push_back(sequence);
+    }
+    void pop_deleted_edge() {
+        sequences_.pop_back();
+        if (ordered_ > sequences_.size()) {
+            const auto position = position_.back();
+            order_.erase(std::begin(order_) + position);
+            for (size_t p{position}; p < order_.size(); ++p) {
+                --position_[order_[p]];
+            }
+            position_.pop_back();
+            partner_.resize(2 * sequences_.size());
+            ordered_ = sequences_.size();
+        }
+    }
+
+    void add_edge(Label a, Label b) {
+        added_.emplace_back(a, b);
+    }
+    void pop_added_edge() {
+        if (partnered_ == added_.size()) {
+            const auto [a, b] = added_.back();
+            partner_[a] = NONE;
+            partner_[b] = NONE;
+            --partnered_;
+        }
+        added_.pop_back();
+    }
+
+    // true if the move, closed with new edge (a, b), is a single tour.
+    bool closes(Label a, Label b) const {
+        update();
+        return cycle_size(0, a, b) == partner_.size();
+    }
+    // number of cycles the move leaves, when every segment end already has its new edge.
+    size_t cycles() const {
+        return cycles(NONE, NONE);
+    }
+    // number of cycles the move, closed with new edge (a, b), leaves.
+    // Also numbers the cycles, for segment_cycle().
+    size_t cycles(Label a, Label b) const {
+        update();
+        cycle_.assign(partner_.size(), NONE);
+        size_t cycles{0};
+        for (Label l{0}; l < partner_.size(); ++l) {
+            if (cycle_[l] != NONE) {
+                continue;
+            }
+            auto current = l;
+            do {
+                cycle_[current] = cycles;
+                const auto other = segment_end(current);
+                cycle_[other] = cycles;
+                current = partner(other, a, b);
+            } while (current != l);
+            ++cycles;
+        }
+        return cycles;
+    }
+
+    // Segments are numbered in tour order: segment s runs from the second point of deleted_edge(s)
+    // to the first point of deleted_edge(s + 1), wrapping around.
+    size_t segments() const { return sequences_.size(); }
+    size_t deleted_edge(size_t segment) const {
+        update();
+        return order_[segment];
+    }
+    // the segment holding the point at sequence (from the same origin as delete_edge()).
+    size_t segment(primitives::sequence_t sequence) const {
+        update();
+        size_t next{0};
+        while (next < order_.size() and sequences_[order_[next]] < sequence) {
+            ++next;
+        }
+        return (next + order_.size() - 1) % order_.size();
+    }
+    // the cycle of a segment, as numbered by the last call to cycles().
+    size_t segment_cycle(size_t segment) const {
+        return cycle_[label(order_[segment], true)];
+    }
+
+    size_t deleted_edges() const { return sequences_.size(); }
+
+    void clear() {
+        sequences_.clear();
+        order_.clear();
+        position_.clear();
+        partner_.clear();
+        added_.clear();
+        ordered_ = 0;
+        partnered_ = 0;
+    }
+
+ private:
+    static constexpr Label NONE{static_cast<Label>(-1)};
+
+    std::vector<primitives::sequence_t> sequences_; // by deleted edge.
+    std::vector<std::pair<Label, Label>> added_;
+    // updated lazily: the first ordered_ deleted edges and partnered_ new edges are reflected below.
+    mutable size_t ordered_{0};
+    mutable size_t partnered_{0};
+    mutable std::vector<size_t> order_; // deleted edges sorted by sequence.
+    mutable std::vector<size_t> position_; // position of each deleted edge in order_.
+    mutable std::vector<Label> partner_; // other end of the new edge at each label.
+    mutable std::vector<size_t> cycle_; // by label.
+
+    void update() const {
+        for (; ordered_ < sequences_.size(); ++ordered_) {
+            const auto e = ordered_;
+            const auto sequence = sequences_[e];
+            size_t position{0};
+            while (position < order_.size() and sequences_[order_[position]] < sequence) {
+                ++position;
+            }
+            order_.insert(std::begin(order_) + position, e);
+            position_.push_back(position);
+            for (size_t p{position + 1}; p < order_.size(); ++p) {
+                ++position_[order_[p]];
+            }
+        }
+        partner_.resize(2 * sequences_.size(), NONE);
+        for (; partnered_ < added_.size(); ++partnered_) {
+            const auto [a, b] = added_[partnered_];
+            partner_[a] = b;
+            partner_[b] = a;
+        }
+    }
+
+    // the label at the other end of the segment starting at l.
+    Label segment_end(Label l) const {
+        const size_t k = order_.size();
+        const size_t e = l / 2;
+        if (l % 2 == 1) {
+            return label(order_[(position_[e] + 1) % k], false);
+        }
+        return label(order_[(position_[e] + k - 1) % k], true);
+    }
+    Label partner(Label l, Label a, Label b) const {
+        if (l == a) {
+            return b;
+        }
+        if (l == b) {
+            return a;
+        }
+        if (partner_[l] == NONE) {
+            throw std::logic_error("segment end without a new edge.");
+        }
+        return partner_[l];
+    }
+    // number of labels on the cycle through l.
+    size_t cycle_size(Label l, Label a, Label b) const {
+        size_t size{0};
+        auto current = l;
+        do {
+            size += 2;
+            current = partner(segment_end(current), a, b);
+        } while (current != l);
+        return size;
+    }
+};
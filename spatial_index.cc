@@ -0,0 +1,46 @@
+#include "spatial_index.hh"
+
+#include "cell_list/grid.hh"
+#include "parallel.hh"
+#include "point_quadtree/index.hh"
+#include "point_quadtree/point_quadtree.h"
+
+#include <iostream>
+#include <stdexcept>
+
+std::vector<std::vector<primitives::point_id_t>> SpatialIndex::knn(size_t k) const {
+    std::vector<std::vector<primitives::point_id_t>> lists(size());
+    parallel::blocks(size(), [this, &lists, k](size_t, size_t begin, size_t end) {
+        for (auto i = begin; i < end; ++i) {
+            lists[i] = knn(i, k);
+        }
+    });
+    return lists;
+}
+
+std::unique_ptr<SpatialIndex> make_spatial_index(const std::string &type
+    , const std::vector<primitives::space_t> &x
+    , const std::vector<primitives::space_t> &y
+    , const point_quadtree::Domain &domain
+    , const std::vector<primitives::space_t> &z
+    , size_t coincident_members) {
+    if (type == "quadtree") {
+        std::cout << "\nquadtree stats:\n";
+        point_quadtree::CoincidentGroups groups(x, y, z, coincident_members);
+        auto root = point_quadtree::make_quadtree(x, y, domain, groups);
+        std::cout << "node ratio: "
+            << static_cast<double>(point_quadtree::count_nodes(root))
+                / point_quadtree::count_points(root)
+            << std::endl;
+        return std::make_unique<point_quadtree::Index>(std::move(root), x, y, std::move(groups));
+    }
+    if (type == "grid") {
+        auto grid = std::make_unique<cell_list::Grid>(x, y, domain, z, coincident_members);
+        std::cout << "\ngrid stats:\n";
+        std::cout << "duplicate points: " << grid->duplicates() << std::endl;
+        std::cout << "cells: " << grid->columns() << " x " << grid->rows() << std::endl;
+        std::cout << "max cell occupancy: " << grid->max_cell_points() << std::endl;
+        return grid;
+    }
+    throw std::invalid_argument("unknown spatial index type: " + type);
+}
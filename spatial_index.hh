@@ -0,0 +1,40 @@
+#pragma once
+
+// Interface for spatial queries over a fixed point set.
+// PointSet answers neighborhood queries through this, so the backing
+// structure (quadtree, uniform grid) can be chosen at run time.
+
+#include "box.hh"
+#include "point_quadtree/Domain.h"
+#include "primitives.hh"
+
+#include <memory> // unique_ptr
+#include <string>
+#include <vector>
+
+class SpatialIndex {
+ public:
+    virtual ~SpatialIndex() = default;
+
+    // Returns (at least) all points within box. i is the query point.
+    // For coincident points, an index may return only the first members of each location, plus the points
+    // that chain i to the rest of its own location (see point_quadtree::CoincidentGroups).
+    virtual std::vector<primitives::point_id_t> get_points(primitives::point_id_t i, const Box &box) const = 0;
+
+    // Returns up to k nearest points to i (excluding i), nearest first; coincident points as for get_points.
+    virtual std::vector<primitives::point_id_t> knn(primitives::point_id_t i, size_t k) const = 0;
+
+    // Returns the k-nearest-neighbor lists of every point, computed in parallel.
+    std::vector<std::vector<primitives::point_id_t>> knn(size_t k) const;
+
+    virtual primitives::point_id_t size() const = 0;
+};
+
+// type: "quadtree" or "grid". z (empty for planar instances) only decides which points coincide.
+// coincident_members: most points of one location that queries return (0: all of them).
+std::unique_ptr<SpatialIndex> make_spatial_index(const std::string &type
+    , const std::vector<primitives::space_t> &x
+    , const std::vector<primitives::space_t> &y
+    , const point_quadtree::Domain &domain
+    , const std::vector<primitives::space_t> &z = {}
+    , size_t coincident_members = 0);
@@ -1,13 +1,19 @@
 #include "tour.hh"
 
+#include <algorithm> // fill
+#include <utility> // move
+
 Tour::Tour(const point_quadtree::Domain* domain
-    , const std::vector<primitives::point_id_t>& initial_tour)
+    , const std::vector<primitives::point_id_t>& initial_tour
+    , LengthFunction length)
 : domain_(domain)
 , adjacents_(initial_tour.size(), {constants::INVALID_POINT, constants::INVALID_POINT})
+, adjacent_lengths_(initial_tour.size(), {0, 0})
 , next_(initial_tour.size(), constants::INVALID_POINT)
+, next_length_(initial_tour.size(), 0)
 , sequence_(initial_tour.size(), constants::INVALID_POINT)
 , box_maker_(domain->x(), domain->y())
-, length_calculator_(domain->x(), domain->y()) {
+, length_(std::move(length)) {
     reset_adjacencies(initial_tour);
     update_next();
 }
@@ -17,6 +23,13 @@ void Tour::swap(const KMove& kmove) {
     update_next();
 }
 
+void Tour::reset(const std::vector<primitives::point_id_t> &order) {
+    std::fill(std::begin(adjacents_), std::end(adjacents_), Adjacents{constants::INVALID_POINT, constants::INVALID_POINT});
+    hash_ = 0;
+    reset_adjacencies(order);
+    update_next();
+}
+
 void Tour::apply_kmove(const KMove &kmove) {
     for (auto p : kmove.removes) {
         break_adjacency(p);
@@ -78,27 +91,25 @@ primitives::point_id_t Tour::prev(primitives::point_id_t i) const {
 
 primitives::length_t Tour::length() const {
     primitives::length_t sum {0};
-    for (primitives::point_id_t i {0}; i < next_.size(); ++i) {
-        sum += length(i);
+    for (const auto length : next_length_) {
+        sum += length;
     }
     return sum;
 }
 
 primitives::length_t Tour::prev_length(primitives::point_id_t i) const {
-    return length_calculator_(i, prev(i));
-}
-
-primitives::length_t Tour::length(primitives::point_id_t i) const {
-    return length_calculator_(i, next_[i]);
+    // the slot not holding next_[i] holds prev(i).
+    return adjacent_lengths_[i][adjacents_[i][0] == next_[i] ? 1 : 0];
 }
 
 primitives::length_t Tour::length(primitives::point_id_t i, primitives::point_id_t j) const {
-    return length_calculator_(i, j);
+    return length_(i, j);
 }
 
 void Tour::update_next(const primitives::point_id_t start) {
     primitives::point_id_t current {start};
     next_[current] = adjacents_[current].front();
+    next_length_[current] = adjacent_lengths_[current].front();
     primitives::point_id_t sequence {0};
     order_.clear();
     order_.reserve(next_.size());
@@ -107,23 +118,24 @@ void Tour::update_next(const primitives::point_id_t start) {
         sequence_[current] = sequence++;
         order_.push_back(current);
         current = next_[current];
-        next_[current] = get_other(current, prev);
+        set_next(current, prev);
     } while (current != start); // tour cycle condition.
     if (order_.size() != next_.size()) {
         throw std::logic_error("order_ was not build up properly.");
     }
 }
 
-primitives::point_id_t Tour::get_other(primitives::point_id_t point, primitives::point_id_t adjacent) const {
-    const auto& a = adjacents_[point];
-    if (a.front() == adjacent) {
-        return a.back();
-    } else {
-        return a.front();
+void Tour::set_next(primitives::point_id_t point, primitives::point_id_t prev) {
+    const size_t slot = adjacents_[point].front() == prev ? 1 : 0;
+    if (next_[point] == adjacents_[point][slot]) {
+        return; // same edge, so next_length_ is still valid.
     }
+    next_[point] = adjacents_[point][slot];
+    next_length_[point] = adjacent_lengths_[point][slot];
 }
 
 void Tour::create_adjacency(primitives::point_id_t point1, primitives::point_id_t point2) {
+    hash_ ^= edge_key(point1, point2);
     fill_adjacent(point1, point2);
     fill_adjacent(point2, point1);
 }
@@ -131,9 +143,11 @@ void Tour::create_adjacency(primitives::point_id_t point1, primitives::point_id_
 void Tour::fill_adjacent(primitives::point_id_t point, primitives::point_id_t new_adjacent) {
     if (adjacents_[point].front() == constants::INVALID_POINT) {
         adjacents_[point].front() = new_adjacent;
+        adjacent_lengths_[point].front() = length_(point, new_adjacent);
     }
     else if (adjacents_[point].back() == constants::INVALID_POINT) {
         adjacents_[point].back() = new_adjacent;
+        adjacent_lengths_[point].back() = length_(point, new_adjacent);
     } else {
         std::cout << __func__ << ": error: no available slot for new adjacent." << std::endl;
         std::cout << point << " -> " << new_adjacent << std::endl;
@@ -146,6 +160,7 @@ void Tour::break_adjacency(primitives::point_id_t i) {
 }
 
 void Tour::break_adjacency(primitives::point_id_t point1, primitives::point_id_t point2) {
+    hash_ ^= edge_key(point1, point2);
     vacate_adjacent_slot(point1, point2);
     vacate_adjacent_slot(point2, point1);
 }
@@ -3,15 +3,16 @@
 #include "box.hh"
 #include "box_maker.hh"
 #include "kmove.hh"
-#include "length_calculator.hh"
 #include "constants.h"
 #include "point_quadtree/Domain.h"
 #include "point_quadtree/node.hh"
 #include "primitives.hh"
 
-#include <algorithm> // fill
+#include <algorithm> // fill, max, min
 #include <array>
+#include <cstdint> // uint64_t
 #include <cstdlib> // abort
+#include <functional>
 #include <iostream>
 #include <random> // sample
 #include <stdexcept>
@@ -20,11 +21,22 @@
 class Tour
 {
 public:
+    using LengthFunction = std::function<primitives::length_t(primitives::point_id_t, primitives::point_id_t)>;
+
     Tour() = default;
+    // metric: one of the policies in metric.hh.
+    template <typename Metric>
+    Tour(const point_quadtree::Domain* domain
+        , const std::vector<primitives::point_id_t>& initial_tour
+        , const Metric &metric)
+        : Tour(domain, initial_tour, LengthFunction(metric)) {}
     Tour(const point_quadtree::Domain* domain
-        , const std::vector<primitives::point_id_t>& initial_tour);
+        , const std::vector<primitives::point_id_t>& initial_tour
+        , LengthFunction length);
 
     void swap(const KMove&);
+    // replaces the tour with the one visiting points in order.
+    void reset(const std::vector<primitives::point_id_t> &order);
     template <typename SequenceContainer = std::vector<primitives::sequence_t>>
     KMove swap_sequence(SequenceContainer starts, SequenceContainer ends, SequenceContainer edges_to_remove);
 
@@ -45,7 +57,9 @@ public:
 
     // total length of tour.
     primitives::length_t length() const;
-    primitives::length_t length(primitives::point_id_t i) const;
+    // length of edge (i, next(i)); cached, so this is a single load.
+    primitives::length_t length(primitives::point_id_t i) const { return next_length_[i]; }
+    // length of edge (prev(i), i); cached.
     primitives::length_t prev_length(primitives::point_id_t i) const;
     primitives::length_t length(primitives::point_id_t i, primitives::point_id_t j) const;
 
@@ -55,6 +69,10 @@ public:
 
     const auto &adjacents() const { return adjacents_; }
 
+    // XOR of a 64-bit key per edge, kept up to date as edges change (O(k) per k-move),
+    // so equal tours have equal hashes and different tours almost surely do not.
+    uint64_t hash() const { return hash_; }
+
     // throws if invalid tour.
     void validate() const;
 
@@ -104,16 +122,31 @@ protected:
     const point_quadtree::Domain* domain_{nullptr};
     using Adjacents = std::array<primitives::point_id_t, 2>;
     std::vector<Adjacents> adjacents_;
+    // adjacent_lengths_[i][s] is the length of edge (i, adjacents_[i][s]), computed when the edge is created.
+    std::vector<std::array<primitives::length_t, 2>> adjacent_lengths_;
     std::vector<primitives::point_id_t> next_;
+    std::vector<primitives::length_t> next_length_; // next_length_[i] is the length of edge (i, next_[i]).
     std::vector<primitives::sequence_t> sequence_;
     std::vector<primitives::point_id_t> order_;
     BoxMaker box_maker_;
-    LengthCalculator length_calculator_;
+    // edge lengths are cached, so this is only called when an edge is created.
+    LengthFunction length_;
+    uint64_t hash_{0};
+
+    // the key of edge (i, j) in hash_: a splitmix64 mix of the ordered pair, so no key table is needed.
+    static uint64_t edge_key(primitives::point_id_t i, primitives::point_id_t j) {
+        auto key = (static_cast<uint64_t>(std::min(i, j)) << 32) | std::max(i, j);
+        key += 0x9E3779B97F4A7C15ULL;
+        key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        key = (key ^ (key >> 27)) * 0x94D049BB133111EBULL;
+        return key ^ (key >> 31);
+    }
 
     void reset_adjacencies(const std::vector<primitives::point_id_t>& initial_tour);
     void update_next(const primitives::point_id_t start = 0);
 
-    primitives::point_id_t get_other(primitives::point_id_t point, primitives::point_id_t adjacent) const;
+    // sets next_ and next_length_ of point to the adjacent that is not prev.
+    void set_next(primitives::point_id_t point, primitives::point_id_t prev);
     void create_adjacency(primitives::point_id_t point1, primitives::point_id_t point2);
     void fill_adjacent(primitives::point_id_t point, primitives::point_id_t new_adjacent);
     void break_adjacency(primitives::point_id_t i);
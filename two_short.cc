@@ -1,5 +1,7 @@
 #include "two_short.hh"
 #include "randomize/randomize.hh"
+
+#include <algorithm> // max, shuffle
 #include <unordered_set>
 
 namespace two_short {
@@ -53,37 +55,66 @@ void insert(PointContainer &removes, EdgeContainer &additions, const KMove &kmov
 
 }  // namespace
 
-std::set<edge::Edge> get_short_edges(const PointSet &point_set, const Tour &tour) {
+template <typename Metric>
+std::set<edge::Edge> get_short_edges(const PointSet<Metric> &point_set, const Tour &tour) {
     std::set<edge::Edge> short_edges;
+    // short edges almost always go to one of the nearest few points,
+    // so the nearest neighbor lists settle most points without a full scan (for planar metrics only; see below).
+    constexpr size_t CANDIDATES{10};
+    const auto &candidates = Metric::PLANAR
+        ? point_set.knn(CANDIDATES) : std::vector<std::vector<primitives::point_id_t>>(point_set.size());
+    std::vector<primitives::length_t> lengths;
     for (primitives::point_id_t i{0}; i < point_set.size(); ++i) {
         const auto &next_length = tour.length(i);
         const auto &prev_length = tour.prev_length(i);
         const auto &max_length = std::max(prev_length, next_length);
-        const auto &search_radius = max_length + 1;
-        const auto &points = point_set.get_points(i, search_radius);
-        std::vector<primitives::point_id_t> filtered_points;
-        for (const auto &point : points) {
-            if (point == tour.next(i) or point == tour.prev(i) or point == i) {
-                continue;
+        const auto add_edge = [&](primitives::point_id_t point) {
+            if (point != tour.next(i) and point != tour.prev(i)) {
+                short_edges.insert(edge::make_edge(i, point));
             }
-            if (point_set.length(point , i) >= max_length) {
-                continue;
+        };
+        const auto &nearest = candidates[i];
+        lengths.resize(nearest.size());
+        point_set.length(i, nearest.data(), nearest.size(), lengths.data());
+        size_t short_count{0};
+        for (size_t k{0}; k < nearest.size(); ++k) {
+            if (lengths[k] < max_length) {
+                add_edge(nearest[k]);
+                ++short_count;
             }
-            filtered_points.push_back(point);
         }
-        if (filtered_points.empty()) {
+        // nearest is ordered by x-y distance, which also orders lengths for planar metrics,
+        // so if some nearest point is not shorter than max_length, no farther point is.
+        // Otherwise (or for other metrics), fall back to a full neighborhood query.
+        if (Metric::PLANAR and (short_count < nearest.size() or nearest.size() < CANDIDATES)) {
             continue;
         }
-        for (const auto &point : filtered_points) {
-            short_edges.insert(edge::make_edge(i, point));
+        const auto &points = point_set.get_points(i, max_length + 1);
+        lengths.resize(points.size());
+        point_set.length(i, points.data(), points.size(), lengths.data());
+        for (size_t k{0}; k < points.size(); ++k) {
+            if (points[k] != i and lengths[k] < max_length) {
+                add_edge(points[k]);
+            }
         }
     }
     return short_edges;
 }
 
+template std::set<edge::Edge> get_short_edges(const PointSet<metric::Euc2d> &, const Tour &);
+template std::set<edge::Edge> get_short_edges(const PointSet<metric::Ceil2d> &, const Tour &);
+template std::set<edge::Edge> get_short_edges(const PointSet<metric::Att> &, const Tour &);
+template std::set<edge::Edge> get_short_edges(const PointSet<metric::Geo> &, const Tour &);
+template std::set<edge::Edge> get_short_edges(const PointSet<metric::Euc3d> &, const Tour &);
+template std::set<edge::Edge> get_short_edges(const PointSet<metric::Matrix<metric::Euc2d>> &, const Tour &);
+template std::set<edge::Edge> get_short_edges(const PointSet<metric::Matrix<metric::Ceil2d>> &, const Tour &);
+template std::set<edge::Edge> get_short_edges(const PointSet<metric::Matrix<metric::Att>> &, const Tour &);
+template std::set<edge::Edge> get_short_edges(const PointSet<metric::Matrix<metric::Geo>> &, const Tour &);
+template std::set<edge::Edge> get_short_edges(const PointSet<metric::Matrix<metric::Euc3d>> &, const Tour &);
+
 KMove make_perturbation(const Tour &tour, std::vector<edge::Edge> &short_edges) {
-    static std::random_device device; // will be used to obtain a seed for the random number engine
-    static std::mt19937 generator(device()); // standard mersenne_twister_engine seeded with random_device.
+    thread_local std::random_device device; // will be used to obtain a seed for the random number engine
+    thread_local std::mt19937 generator(device()); // standard mersenne_twister_engine seeded with random_device.
     std::shuffle(std::begin(short_edges), std::end(short_edges), generator);
     KMove large_kmove;
     std::unordered_set<primitives::point_id_t> removed;
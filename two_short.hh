@@ -8,13 +8,16 @@
 #include "randomize/randomize.hh"
 
 #include <array>
+#include <optional>
 #include <random>
 #include <vector>
 #include <set>
 
 namespace two_short {
 
-std::set<edge::Edge> get_short_edges(const PointSet &point_set, const Tour &tour);
+// instantiated for every metric in metric.hh.
+template <typename Metric>
+std::set<edge::Edge> get_short_edges(const PointSet<Metric> &point_set, const Tour &tour);
 KMove make_perturbation(const Tour &tour, std::vector<edge::Edge> &short_edges);
 
 }  // namespace two_short